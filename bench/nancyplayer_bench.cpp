@@ -0,0 +1,369 @@
+// Microbenchmarks for the hot paths of startup, search, browsing and playback.
+// Prints one JSON object per benchmark and line, so runs can be collected and
+// compared over time:
+//
+//   {"benchmark":"search_broad","iterations":42,"min_ns":...,"median_ns":...,
+//    "mean_ns":...,"items":1000,"items_per_second":...}
+//
+// Usage: nancyplayer_bench [--hvsc DIR] [--dir DIR] [--tune FILE] [--min-time SEC] [--filter TEXT]
+// The HVSC root defaults to hvsc_root from the config file.
+
+#include "catalog.h"
+#include "search.h"
+#include "file_browser.h"
+#include "engine_slot.h"
+#include "mapped_file.h"
+#include "config.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const int ENGINE_SAMPLE_RATE = 44100;
+static const size_t ENGINE_CHUNK_SAMPLES = 1024; // what the player renders per step
+static const size_t ENGINE_SAMPLES_PER_ITERATION = ENGINE_SAMPLE_RATE * 10;
+static const int MAX_ITERATIONS = 1000;
+static const size_t BENCH_FAILED = SIZE_MAX; // returned by a body that could not do its work
+
+struct BenchOptions {
+    std::string hvsc_root;
+    std::string scan_dir;
+    std::string tune_path;
+    std::string filter;
+    double min_time = 1.0;
+};
+
+static std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+static bool isSelected(const BenchOptions& options, const std::string& name) {
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+// Runs body until min_time has passed (at least once) and reports the
+// distribution of iteration times. body returns the number of items it
+// processed, used for the throughput figure, or BENCH_FAILED, which skips
+// the benchmark without a record. extra_fields, if given, adds
+// members to the JSON object, like ",\"memory_bytes\":123".
+static void runBenchmark(const BenchOptions& options, const std::string& name, const std::string& detail,
+                         const std::function<size_t()>& body,
+                         const std::function<std::string()>& extra_fields = nullptr) {
+    if (!isSelected(options, name)) {
+        return;
+    }
+    
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> times_ns;
+    size_t items = 0;
+    auto deadline = Clock::now() + std::chrono::duration<double>(options.min_time);
+    do {
+        auto started = Clock::now();
+        items = body();
+        if (items == BENCH_FAILED) {
+            std::cerr << "nancyplayer_bench: " << name << " failed, skipped" << std::endl;
+            return;
+        }
+        times_ns.push_back(std::chrono::duration<double, std::nano>(Clock::now() - started).count());
+    } while (Clock::now() < deadline && static_cast<int>(times_ns.size()) < MAX_ITERATIONS);
+    
+    double total_ns = 0;
+    for (double time : times_ns) {
+        total_ns += time;
+    }
+    double mean_ns = total_ns / times_ns.size();
+    std::sort(times_ns.begin(), times_ns.end());
+    double median_ns = times_ns[times_ns.size() / 2];
+    
+    std::string extra = extra_fields ? extra_fields() : "";
+    std::printf("{\"benchmark\":\"%s\",\"detail\":\"%s\",\"iterations\":%zu,\"min_ns\":%.0f,\"median_ns\":%.0f,"
+                "\"mean_ns\":%.0f,\"items\":%zu,\"items_per_second\":%.1f%s}\n",
+                jsonEscape(name).c_str(), jsonEscape(detail).c_str(), times_ns.size(), times_ns.front(), median_ns,
+                mean_ns, items, median_ns > 0 ? items * 1e9 / median_ns : 0, extra.c_str());
+    std::fflush(stdout);
+}
+
+// The directory with the most entries, where a browser scan hurts most
+static std::string findLargestDirectory(const std::string& root) {
+    std::string largest = root;
+    size_t largest_count = 0;
+    std::error_code error;
+    auto options = std::filesystem::directory_options::skip_permission_denied;
+    for (std::filesystem::recursive_directory_iterator it(root, options, error), end; it != end; it.increment(error)) {
+        if (error) {
+            break;
+        }
+        if (!it->is_directory(error)) {
+            continue;
+        }
+        size_t count = 0;
+        for (std::filesystem::directory_iterator entry(it->path(), error), entries_end; !error && entry != entries_end; entry.increment(error)) {
+            count++;
+        }
+        if (count > largest_count) {
+            largest = it->path().string();
+            largest_count = count;
+        }
+    }
+    return largest;
+}
+
+// The catalog's heap use, to check against the budget in catalog.h
+static std::string catalogMemoryFields(size_t memory_bytes, size_t songs) {
+    char fields[96];
+    std::snprintf(fields, sizeof(fields), ",\"memory_bytes\":%zu,\"bytes_per_song\":%.1f", memory_bytes,
+                  songs > 0 ? static_cast<double>(memory_bytes) / songs : 0);
+    return fields;
+}
+
+static void benchCatalog(const BenchOptions& options) {
+    size_t memory_bytes = 0;
+    size_t songs = 0;
+    auto memory_fields = [&] { return catalogMemoryFields(memory_bytes, songs); };
+    
+    // Each parser alone, so a regression in one is not hidden by the other
+    runBenchmark(options, "songlengths_parse", options.hvsc_root, [&] {
+        Catalog catalog;
+        catalog.loadDocument(options.hvsc_root, "Songlengths.md5");
+        return catalog.getSongCount();
+    });
+    runBenchmark(options, "stil_parse", options.hvsc_root, [&] {
+        Catalog catalog;
+        catalog.loadDocument(options.hvsc_root, "STIL.txt");
+        return catalog.getStilCount();
+    });
+    
+    // Cold start: parse Songlengths.md5 and STIL.txt from text
+    runBenchmark(options, "catalog_parse", options.hvsc_root, [&] {
+        Catalog catalog;
+        catalog.load(options.hvsc_root);
+        memory_bytes = catalog.getMemoryUsage();
+        songs = catalog.getSongCount();
+        return songs;
+    }, memory_fields);
+    
+    // Warm start: map the binary index written by a previous load
+    std::filesystem::path cache_dir = std::filesystem::temp_directory_path() / "nancyplayer_bench_cache";
+    std::error_code error;
+    std::filesystem::create_directories(cache_dir, error);
+    {
+        Catalog catalog;
+        catalog.load(options.hvsc_root, cache_dir.string());
+    }
+    runBenchmark(options, "catalog_load_cached", options.hvsc_root, [&] {
+        Catalog catalog;
+        catalog.load(options.hvsc_root, cache_dir.string());
+        memory_bytes = catalog.getMemoryUsage();
+        songs = catalog.getSongCount();
+        return songs;
+    }, memory_fields);
+    std::filesystem::remove_all(cache_dir, error);
+}
+
+static void benchSearch(const BenchOptions& options, const std::shared_ptr<const Catalog>& catalog) {
+    Search search;
+    search.setCatalog(catalog);
+    runBenchmark(options, "search_index_build", "", [&] {
+        search.setCatalog(catalog);
+        return catalog->getSongCount();
+    });
+    
+    // Items are the matches found, so broad queries show their ranking cost
+    const std::pair<const char*, const char*> queries[] = {
+        {"search_short", "hub"},
+        {"search_long", "monty on the run"},
+        {"search_broad", "a"},
+    };
+    for (const auto& [name, query] : queries) {
+        runBenchmark(options, name, query, [&, query = query] {
+            return search.search(query).total_matches;
+        });
+    }
+    
+    SearchSession session;
+    runBenchmark(options, "search_fuzzy", "mntyrn", [&] {
+        session.reset();
+        return search.search("mntyrn", session, SearchProgress(), SearchMode::Fuzzy).total_matches;
+    });
+}
+
+static void benchBrowser(const BenchOptions& options) {
+    if (!isSelected(options, "browser_scan")) {
+        return;
+    }
+    std::string directory = options.scan_dir.empty() ? findLargestDirectory(options.hvsc_root) : options.scan_dir;
+    FileBrowser browser;
+    browser.setHvscRoot(options.hvsc_root);
+    browser.setDirectory(directory);
+    runBenchmark(options, "browser_scan", directory, [&] {
+        browser.refresh();
+        return browser.getEntries().size();
+    });
+}
+
+// The tune given with --tune or the first one of the catalog on disk, parsed
+static std::unique_ptr<SidTune> loadBenchTune(const BenchOptions& options, const Catalog* catalog,
+                                              const std::string& benchmark, std::string& tune_path) {
+    tune_path = options.tune_path;
+    if (tune_path.empty() && catalog) {
+        for (const auto& song : catalog->getSongs()) {
+            std::string path = options.hvsc_root + std::string(song.path);
+            if (std::filesystem::is_regular_file(path)) {
+                tune_path = path;
+                break;
+            }
+        }
+    }
+    
+    MappedFile file;
+    if (tune_path.empty() || !file.open(tune_path)) {
+        std::cerr << "nancyplayer_bench: no tune for " << benchmark << ", give one with --tune" << std::endl;
+        return nullptr;
+    }
+    auto tune = std::make_unique<SidTune>(reinterpret_cast<const uint_least8_t*>(file.getData()),
+                                          static_cast<uint_least32_t>(file.getSize()));
+    if (!tune->getStatus()) {
+        std::cerr << "nancyplayer_bench: cannot parse " << tune_path << std::endl;
+        return nullptr;
+    }
+    return tune;
+}
+
+// Load to first sample: what the player does before the first chunk of a
+// tune can go out, on a newly built slot against a recycled one
+static void benchPlayerLoad(const BenchOptions& options, const Catalog* catalog) {
+    if (!isSelected(options, "player_load_cold") && !isSelected(options, "player_load_warm")) {
+        return;
+    }
+    std::string tune_path;
+    std::unique_ptr<SidTune> tune = loadBenchTune(options, catalog, "player_load", tune_path);
+    if (!tune) {
+        return;
+    }
+    
+    // Renders the first chunk, then takes the tune back the way the player
+    // recycles a slot
+    std::vector<short> chunk(ENGINE_CHUNK_SAMPLES);
+    auto loadInto = [&](EngineSlot& slot) {
+        if (!slot.configure(ENGINE_SAMPLE_RATE) || !slot.loadTune(tune, 0)) {
+            return false;
+        }
+        bool played = slot.engine->play(chunk.data(), static_cast<uint_least32_t>(chunk.size())) > 0;
+        slot.engine->load(nullptr);
+        tune = std::move(slot.tune);
+        return played;
+    };
+    
+    runBenchmark(options, "player_load_cold", tune_path, [&] {
+        std::unique_ptr<EngineSlot> slot = EngineSlot::create();
+        return slot && loadInto(*slot) ? ENGINE_CHUNK_SAMPLES : BENCH_FAILED;
+    });
+    
+    std::unique_ptr<EngineSlot> warm_slot = EngineSlot::create();
+    if (!warm_slot || !loadInto(*warm_slot)) {
+        std::cerr << "nancyplayer_bench: cannot load " << tune_path << ", player_load_warm skipped" << std::endl;
+        return;
+    }
+    runBenchmark(options, "player_load_warm", tune_path, [&] {
+        return loadInto(*warm_slot) ? ENGINE_CHUNK_SAMPLES : BENCH_FAILED;
+    });
+}
+
+static void benchEngine(const BenchOptions& options, const Catalog* catalog) {
+    if (!isSelected(options, "engine_play")) {
+        return;
+    }
+    std::string tune_path;
+    std::unique_ptr<SidTune> tune = loadBenchTune(options, catalog, "engine_play", tune_path);
+    std::unique_ptr<EngineSlot> slot = tune ? EngineSlot::create() : nullptr;
+    if (!slot || !slot->configure(ENGINE_SAMPLE_RATE) || !slot->loadTune(tune, 0)) {
+        if (tune) {
+            std::cerr << "nancyplayer_bench: cannot play " << tune_path << std::endl;
+        }
+        return;
+    }
+    
+    // Items are samples, so items_per_second is the emulation's output rate
+    std::vector<short> chunk(ENGINE_CHUNK_SAMPLES);
+    runBenchmark(options, "engine_play", tune_path, [&] {
+        size_t rendered = 0;
+        while (rendered < ENGINE_SAMPLES_PER_ITERATION) {
+            int samples = static_cast<int>(slot->engine->play(chunk.data(), static_cast<uint_least32_t>(chunk.size())));
+            if (samples <= 0) {
+                break;
+            }
+            rendered += samples;
+        }
+        return rendered;
+    });
+}
+
+static void printUsage() {
+    std::cerr << "Usage: nancyplayer_bench [options]\n"
+              << "  --hvsc DIR      HVSC root (default: hvsc_root from the config)\n"
+              << "  --dir DIR       directory for browser_scan (default: the largest below the root)\n"
+              << "  --tune FILE     tune for player_load and engine_play (default: the first one in the catalog)\n"
+              << "  --min-time SEC  minimum time per benchmark (default: 1)\n"
+              << "  --filter TEXT   only run benchmarks whose name contains TEXT\n";
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--hvsc" && has_value) {
+            options.hvsc_root = argv[++i];
+        } else if (arg == "--dir" && has_value) {
+            options.scan_dir = argv[++i];
+        } else if (arg == "--tune" && has_value) {
+            options.tune_path = argv[++i];
+        } else if (arg == "--min-time" && has_value) {
+            options.min_time = std::atof(argv[++i]);
+        } else if (arg == "--filter" && has_value) {
+            options.filter = argv[++i];
+        } else {
+            printUsage();
+            return arg == "-h" || arg == "--help" ? 0 : 2;
+        }
+    }
+    
+    if (options.hvsc_root.empty()) {
+        Config config;
+        config.loadConfig();
+        options.hvsc_root = config.getHvscRoot();
+    }
+    
+    auto catalog = std::make_shared<Catalog>();
+    if (!catalog->load(options.hvsc_root)) {
+        std::cerr << "nancyplayer_bench: cannot load the HVSC database below '" << options.hvsc_root << "'" << std::endl;
+        return 1;
+    }
+    
+    benchCatalog(options);
+    benchSearch(options, catalog);
+    benchBrowser(options);
+    benchPlayerLoad(options, catalog.get());
+    benchEngine(options, catalog.get());
+    return 0;
+}
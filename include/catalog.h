@@ -0,0 +1,130 @@
+#pragma once
+
+#include "string_arena.h"
+#include <string>
+#include <string_view>
+#include <span>
+#include <array>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
+
+// All strings and arrays below are views into storage owned by the Catalog
+// and stay valid for as long as the Catalog they came from is alive.
+
+struct StilEntry {
+    std::string_view title;
+    std::string_view artist; // interned, equal artists share one string
+    std::string_view comment;
+    std::string_view copyright;
+    std::span<const std::string_view> subtune_info;
+};
+
+// Binary MD5 digest as found in Songlengths.md5, all zero if unknown
+using Md5Digest = std::array<uint8_t, 16>;
+
+struct Md5DigestHash {
+    size_t operator()(const Md5Digest& digest) const;
+};
+
+bool parseMd5Digest(std::string_view hex, Md5Digest& digest);
+std::string formatMd5Digest(const Md5Digest& digest);
+
+struct SongEntry {
+    std::string_view path;
+    std::string_view filename; // tail of path
+    std::span<const int> lengths; // lengths for each subtune in seconds
+    Md5Digest md5 = {};
+    const StilEntry* stil = nullptr; // owned by the Catalog, null if not in STIL
+    
+    std::string_view title() const { return stil ? stil->title : std::string_view(); }
+    std::string_view artist() const { return stil ? stil->artist : std::string_view(); }
+    
+    std::string getDisplayName() const {
+        if (!title().empty() && !artist().empty()) {
+            return std::string(artist()).append(" - ").append(title());
+        } else if (!title().empty()) {
+            return std::string(title());
+        } else {
+            return std::string(filename);
+        }
+    }
+};
+
+// Reports loading progress from the thread running Catalog::load
+using CatalogProgressCallback = std::function<void(const char* stage, int percent)>;
+
+// HVSC metadata parsed once from Songlengths.md5 and STIL.txt. StilReader and
+// Search are both views onto a shared, immutable Catalog.
+//
+// Memory budget per song; nancyplayer_bench reports getMemoryUsage() with
+// its catalog_* entries to check it:
+//   SongEntry record                     72 bytes
+//   path text in the arena               ~47 bytes (HVSC average)
+//   lengths                               4 bytes per subtune
+//   path and MD5 hash index nodes        ~96 bytes
+// STIL entries add an 80 byte record, their text and one index node, with
+// artists interned so a composer costs one string. A 60k song catalog with
+// 20k STIL entries comes to about 300 bytes per song, 18 MB in total.
+class Catalog {
+public:
+    Catalog();
+    Catalog(const Catalog&) = delete;
+    Catalog& operator=(const Catalog&) = delete;
+    
+    bool load(const std::string& hvsc_root, const std::string& cache_dir = "",
+              const CatalogProgressCallback& on_progress = nullptr);
+    // Parses only one of the documents load() reads, "Songlengths.md5" or
+    // "STIL.txt", without the index cache; lets the parsers be timed apart
+    bool loadDocument(const std::string& hvsc_root, const std::string& name);
+    
+    const std::vector<SongEntry>& getSongs() const { return songs; }
+    const SongEntry* findSong(std::string_view hvsc_path) const;
+    const SongEntry* findSongByMd5(const Md5Digest& md5) const;
+    const StilEntry* findStil(std::string_view hvsc_path) const;
+    size_t getSongCount() const { return songs.size(); }
+    size_t getStilCount() const { return stil_entries.size(); }
+    
+    // Approximate heap bytes held by the catalog, see the budget above
+    size_t getMemoryUsage() const;
+    
+    // Converts a filesystem path below the HVSC root to "/DIR/File.sid" form
+    std::string toHvscPath(const std::string& sid_file_path) const;
+    const std::string& getHvscRoot() const { return hvsc_root_path; }
+
+private:
+    // Subtune lengths and STIL subtune lines are collected in flat arrays while
+    // loading; ranges into them become spans once the arrays stop growing.
+    struct Range {
+        uint32_t begin = 0;
+        uint32_t count = 0;
+    };
+    
+    void reportProgress(const char* stage, int percent) const;
+    void parseSonglengthsFile(const std::string& songlengths_file_path);
+    void parseStilFile(const std::string& stil_file_path);
+    void addSong(const SongEntry& entry, Range lengths);
+    void addStil(std::string_view hvsc_path, const StilEntry& entry, Range subtunes);
+    void finalize();
+    void clear();
+    bool loadIndexCache(const std::string& cache_path, const std::vector<std::string>& source_paths);
+    void saveIndexCache(const std::string& cache_path, const std::vector<std::string>& source_paths) const;
+    
+    StringArena arena;
+    StringInterner artists;
+    
+    std::vector<SongEntry> songs;
+    std::vector<Range> song_length_ranges; // parallel to songs, only used while loading
+    std::vector<int> song_lengths;
+    std::unordered_map<std::string_view, uint32_t> song_index; // normalized path to songs index
+    std::unordered_map<Md5Digest, uint32_t, Md5DigestHash> md5_index;
+    
+    std::vector<StilEntry> stil_entries;
+    std::vector<Range> stil_subtune_ranges; // parallel to stil_entries, only used while loading
+    std::vector<std::string_view> stil_subtunes;
+    std::unordered_map<std::string_view, uint32_t> stil_index;
+    
+    std::string hvsc_root_path;
+    CatalogProgressCallback progress_callback; // only set during load()
+};
\ No newline at end of file
@@ -64,7 +64,9 @@ public:
     
     std::string getConfigDir() const { return config_dir; }
     std::string getThemesDir() const { return themes_dir; }
+    std::string getCacheDir() const { return cache_dir; }
     std::string getHvscRoot() const { return hvsc_root; }
+    int getAudioBufferMs() const { return audio_buffer_ms; }
     std::string getRelativeToHvsc(const std::string& path) const;
     bool validateHvscRoot() const;
     
@@ -77,8 +79,10 @@ private:
     
     std::string config_dir;
     std::string themes_dir;
+    std::string cache_dir;
     std::string config_file;
     std::string hvsc_root;
+    int audio_buffer_ms; // how far emulation may run ahead of the audio output
     Theme current_theme;
     std::string current_theme_name;
 };
\ No newline at end of file
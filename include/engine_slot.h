@@ -0,0 +1,36 @@
+#pragma once
+
+#include "index_cache.h"
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <sidplayfp/sidplayfp.h>
+#include <sidplayfp/SidTune.h>
+#include <sidplayfp/SidTuneInfo.h>
+#include <sidplayfp/SidConfig.h>
+#include <sidplayfp/builders/residfp.h>
+
+// A tune ready to play on its own engine, loaded and set to one subtune.
+// The Player recycles finished slots: the configured engine and its SID
+// chips are kept, the tune goes back to the SidTuneCache it came from.
+struct EngineSlot {
+    // The builder owns the SID chips the engine plays, so it is declared
+    // first and outlives the engine
+    std::unique_ptr<ReSIDfpBuilder> builder;
+    std::unique_ptr<sidplayfp> engine;
+    std::unique_ptr<SidTune> tune;
+    std::string tune_path;
+    SourceStamp tune_stamp;
+    int track = 1;
+    uint64_t length_samples = 0; // 0 if unknown, the track then plays until stopped
+    uint64_t queue_id = 0;       // set for queued tunes
+    
+    // Builds an engine with SID chips for as many SIDs as any tune can use,
+    // so the slot can be reused for every tune later on. Null on failure.
+    static std::unique_ptr<EngineSlot> create();
+    // Sets up mono output at sample_rate. Configuring rebuilds the emulation,
+    // so nothing is done if the engine already runs with that setup.
+    bool configure(int sample_rate);
+    // Loads tune set to track, 0 for its start song. Takes the tune on success.
+    bool loadTune(std::unique_ptr<SidTune>& new_tune, int new_track);
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+// Wakes a thread sleeping in EventLoop::wait() from any other thread. Backed
+// by an eventfd, so any number of notify() calls before the wake-up collapse
+// into a single event.
+class EventNotifier {
+public:
+    EventNotifier();
+    ~EventNotifier();
+    EventNotifier(const EventNotifier&) = delete;
+    EventNotifier& operator=(const EventNotifier&) = delete;
+    
+    void notify(); // safe from any thread and from signal handlers
+    void drain();
+    int getFd() const { return fd; }
+    
+private:
+    int fd;
+};
+
+// epoll based main loop. The calling thread sleeps until a watched file
+// descriptor is readable, a watched signal arrives or a notifier fires.
+class EventLoop {
+public:
+    using Handler = std::function<void()>;
+    
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+    
+    bool watch(int fd, Handler handler);
+    bool watch(EventNotifier& notifier, Handler handler);
+    // Blocks signal_number and receives it through a signalfd instead. Must be
+    // called before other threads start so none of them inherits it unblocked.
+    bool watchSignal(int signal_number, Handler handler);
+    
+    // Sleeps until at least one event (or timeout_ms, -1 for none) and runs
+    // the handlers of everything that is ready. Returns the number handled.
+    int wait(int timeout_ms = -1);
+    
+private:
+    struct Watch {
+        int fd;
+        Handler handler;
+    };
+    
+    bool add(int fd, Handler handler);
+    
+    int epoll_fd;
+    std::vector<std::unique_ptr<Watch>> watches;
+    std::vector<int> owned_fds;
+};
\ No newline at end of file
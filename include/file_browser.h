@@ -7,6 +7,7 @@
 struct FileEntry {
     std::string name;
     std::string path;
+    std::string hvsc_path; // "/DIR/File.sid" catalog key, empty outside the HVSC root
     bool is_directory;
     bool is_sid_file;
 };
@@ -15,6 +16,7 @@ class FileBrowser {
 public:
     FileBrowser();
     
+    void setHvscRoot(const std::string& path);
     void setDirectory(const std::string& path);
     void refresh();
     void moveUp();
@@ -26,13 +28,18 @@ public:
     const std::vector<FileEntry>& getEntries() const { return entries; }
     int getSelectedIndex() const { return selected_index; }
     std::string getCurrentPath() const { return current_path; }
+    const std::string& getCurrentHvscPath() const { return current_hvsc_path; }
     std::string getSelectedFile() const;
+    const FileEntry* getSelectedEntry() const;
     
 private:
     void scanDirectory();
+    void updateHvscPaths();
     bool isSidFile(const std::string& filename);
     
     std::string current_path;
+    std::string hvsc_root; // canonical, resolved once so scans need no extra syscalls
+    std::string current_hvsc_path;
     std::vector<FileEntry> entries;
     int selected_index;
 };
\ No newline at end of file
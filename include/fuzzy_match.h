@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// fzf-style subsequence matching over pre-folded (lowercased) text.
+namespace fuzzy {
+
+// Bitmask of the letters and digits occurring in text. If a pattern's mask is
+// not a subset of a text's mask, the pattern cannot be a subsequence of it.
+uint32_t charMask(std::string_view text);
+
+// Appends to out every id whose mask contains all bits of pattern_mask.
+// SIMD-vectorized; masks is indexed by id.
+void filterByMask(const uint32_t* masks, const uint32_t* ids, size_t count, uint32_t pattern_mask, std::vector<uint32_t>& out);
+
+// Scores the shortest window of text ending at the leftmost complete match:
+// higher for matches at word starts and in consecutive runs, lower for gaps.
+// Returns -1 if pattern is not a subsequence of text. The scans over text
+// are SIMD-vectorized; the scoring itself visits only matched positions.
+int score(std::string_view text, std::string_view pattern);
+
+}
\ No newline at end of file
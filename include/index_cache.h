@@ -0,0 +1,61 @@
+#pragma once
+
+#include "mapped_file.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Size and modification time of a source database file. A cached index is
+// only valid while every source it was built from still matches its stamp.
+struct SourceStamp {
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+    
+    static bool read(const std::string& path, SourceStamp& stamp);
+    bool operator==(const SourceStamp& other) const {
+        return size == other.size && mtime_ns == other.mtime_ns;
+    }
+};
+
+// Builds a binary index in memory and writes it to disk atomically. The
+// header records the path and stamp of every source.
+class IndexCacheWriter {
+public:
+    IndexCacheWriter(const std::string& kind, const std::vector<std::string>& source_paths);
+    
+    void writeU32(uint32_t value);
+    void writeString(std::string_view value);
+    void writeBytes(const void* data, size_t length);
+    bool commit(const std::string& cache_path);
+
+private:
+    std::string buffer;
+    bool stamps_valid;
+};
+
+// Memory-maps a binary index written by IndexCacheWriter. open() fails if the
+// file is missing, of another kind or version, built from other source paths
+// or stale w.r.t. its sources.
+class IndexCacheReader {
+public:
+    IndexCacheReader();
+    ~IndexCacheReader();
+    IndexCacheReader(const IndexCacheReader&) = delete;
+    IndexCacheReader& operator=(const IndexCacheReader&) = delete;
+    
+    bool open(const std::string& cache_path, const std::string& kind, const std::vector<std::string>& source_paths);
+    void close();
+    
+    bool readU32(uint32_t& value);
+    bool readString(std::string_view& value);
+    bool readBytes(void* out, size_t length);
+    bool ok() const { return !failed; }
+
+private:
+    MappedFile file;
+    const char* data;
+    size_t size;
+    size_t pos;
+    bool failed;
+};
\ No newline at end of file
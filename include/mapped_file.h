@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file, unmapped on destruction.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    bool open(const std::string& path);
+    void close();
+    
+    bool isOpen() const { return data != nullptr; }
+    const char* getData() const { return data; }
+    size_t getSize() const { return size; }
+    std::string_view view() const { return std::string_view(data, size); }
+    
+private:
+    const char* data;
+    size_t size;
+};
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+enum class PcmFormat {
+    Wav, // 16-bit mono RIFF WAVE
+    Raw  // headerless 16-bit signed little-endian mono samples
+};
+
+// One subtune to render to a file
+struct RenderJob {
+    std::string input_path;
+    std::string output_path;
+    int track = 0;                 // 0 for the tune's start song
+    int64_t length_ms = 0;         // overrides song_lengths when set
+    std::vector<int> song_lengths; // seconds per subtune, e.g. from Songlengths.md5
+    PcmFormat format = PcmFormat::Wav;
+    int sample_rate = 44100;
+};
+
+struct RenderStats {
+    int track = 0; // subtune actually rendered
+    uint64_t samples = 0;
+    double elapsed_seconds = 0;
+    
+    double getRenderedSeconds(int sample_rate) const { return static_cast<double>(samples) / sample_rate; }
+    // How many seconds of audio were rendered per second of wall time
+    double getRealtimeFactor(int sample_rate) const {
+        return elapsed_seconds > 0 ? getRenderedSeconds(sample_rate) / elapsed_seconds : 0;
+    }
+};
+
+struct EngineSlot;
+
+// Renders a subtune straight from the emulation into a file, as fast as the
+// CPU allows and without an audio device. Returns false and sets error if
+// the tune cannot be loaded, its length is unknown or the output fails.
+bool renderToFile(const RenderJob& job, RenderStats& stats, std::string& error);
+// Same on an existing engine, which is reconfigured only if needed. Lets a
+// worker rendering many tunes keep one engine.
+bool renderToFile(EngineSlot& slot, const RenderJob& job, RenderStats& stats, std::string& error);
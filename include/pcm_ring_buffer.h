@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Lock-free single-producer/single-consumer ring of 16-bit PCM samples. The
+// producer only calls write(), the consumer only calls read(); positions are
+// free-running counters published with release/acquire ordering.
+//
+// The producer can also drop everything written so far with discard(), e.g.
+// on a track change. The consumer notices through getDiscardCount() and
+// catches up with skipDiscarded() before its next read.
+//
+// Either side can sleep without a lock: take getChangeToken(), re-check its
+// condition, then waitForChange(token). Every read, write and wake() changes
+// the token, so a change between the check and the wait is never missed.
+class PcmRingBuffer {
+public:
+    explicit PcmRingBuffer(size_t min_capacity);
+    PcmRingBuffer(const PcmRingBuffer&) = delete;
+    PcmRingBuffer& operator=(const PcmRingBuffer&) = delete;
+    
+    size_t write(const short* samples, size_t count); // producer only, returns samples taken
+    size_t read(short* samples, size_t count);        // consumer only, returns samples copied
+    void discard();                                    // producer only
+    bool skipDiscarded();                              // consumer only, true if samples were dropped
+    uint32_t getDiscardCount() const { return discards.load(std::memory_order_acquire); }
+    
+    size_t getReadable() const; // excludes discarded samples the consumer has not skipped yet
+    size_t getWritable() const; // free space the producer can write right now
+    size_t capacity() const { return buffer.size(); }
+    // Samples written and read since the last clear(), to mark places in the stream
+    size_t getWritePosition() const { return write_pos.load(std::memory_order_acquire); }
+    size_t getReadPosition() const { return read_pos.load(std::memory_order_acquire); }
+    void clear(); // only while neither side is running
+    
+    uint32_t getChangeToken() const { return changes.load(std::memory_order_acquire); }
+    void waitForChange(uint32_t token) const { changes.wait(token, std::memory_order_acquire); }
+    void wake(); // wakes both sides, e.g. to make them notice a stop request
+    
+private:
+    std::vector<short> buffer;
+    size_t mask;
+    
+    // Kept on separate cache lines so producer and consumer do not contend
+    alignas(64) std::atomic<size_t> write_pos;
+    std::atomic<size_t> discard_pos;
+    std::atomic<uint32_t> discards;
+    alignas(64) std::atomic<size_t> read_pos;
+    alignas(64) std::atomic<uint32_t> changes;
+};
\ No newline at end of file
@@ -4,55 +4,219 @@
 #include <memory>
 #include <thread>
 #include <atomic>
-#include <sidplayfp/sidplayfp.h>
-#include <sidplayfp/SidInfo.h>
-#include <sidplayfp/SidTune.h>
-#include <sidplayfp/SidTuneInfo.h>
-#include <sidplayfp/SidConfig.h>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <cstdint>
+#include "pcm_ring_buffer.h"
+#include "spsc_queue.h"
+#include "sid_tune_cache.h"
+#include "engine_slot.h"
 
+// What the player is doing, as last requested through its control methods
+// or reached by advancing to the queued tune. Snapshots are immutable once
+// published, so any thread can keep and read one while newer ones replace
+// it; version grows with every publication.
+struct PlayerState {
+    uint64_t version = 0;
+    std::string file;
+    std::string title;
+    std::string author;
+    std::string copyright;
+    int track = 1;
+    int track_count = 0;
+    bool playing = false;
+    bool paused = false;
+    std::string next_file; // queued to follow the current track, empty if none
+    int next_track = 0;
+};
+
+// Control operation for the render thread, see Player
+struct PlayerCommand {
+    enum Type {
+        None,
+        Load,        // replace the current slot, stopped
+        Queue,       // replace the slot that follows the current track
+        Play,        // start or resume
+        Pause,
+        Stop,        // stop and rewind the current track
+        SelectTrack, // switch subtune, keeps playing if playing
+        Seek,        // jump within the current track
+        Quit
+    };
+    
+    Type type = None;
+    std::unique_ptr<EngineSlot> slot;
+    int track = 0;
+    int64_t length_ms = 0;   // SelectTrack
+    int64_t position_ms = 0; // Seek
+};
+
+// Looks up the length of a subtune in milliseconds, 0 if unknown
+using SongLengthLookup = std::function<int64_t(const std::string& filename, int track)>;
+
+// Plays SID tunes on two threads: the render thread owns the emulation and
+// fills a PCM ring, the audio thread drains the ring into PulseAudio.
+//
+// The control methods are meant to be called from a single thread (the UI).
+// They publish a new PlayerState snapshot right away and post a
+// PlayerCommand that the render thread applies between two chunks, so they
+// never wait for the emulation or join a thread. Tunes are parsed and set up
+// on their own engine by the preparer thread, which posts the ready slot the
+// same way; until then a loaded file's snapshot has no title or tracks.
+// Audio rendered before a track change, seek or stop is discarded from the
+// ring and flushed from the output, so the new position is heard without a
+// gap or a stale tail.
+//
+// For gapless playback a second tune can be queued with queueFile(). The
+// preparer thread sets it up while the current one plays; once the current
+// track reaches its length the render thread switches engines between two
+// chunks, and the audio thread publishes the new state once the first sample
+// of the queued tune is audible, at the position getPlayTimeMs() reports.
+// The output stream is never interrupted.
 class Player {
 public:
     Player();
     ~Player();
     
-    bool loadFile(const std::string& filename);
+    // Replaces the current tune, stopped; play() may follow right away. If
+    // the tune cannot be loaded the snapshot's file is cleared again.
+    void loadFile(const std::string& filename);
+    // Queues filename's subtune to follow the current track, replacing
+    // whatever was queued. If the tune cannot be prepared the queue is
+    // dropped again, and false is returned for that tune until the next
+    // loadFile(). Track changes, stop and loading drop the queue.
+    bool queueFile(const std::string& filename, int track);
     void play();
     void pause();
     void stop();
     void nextTrack();
     void prevTrack();
+    void seek(int64_t position_ms); // clamped at the start of the track
+    
+    // Latest published snapshot, never null. Compare versions to find out
+    // whether anything changed since the last look.
+    std::shared_ptr<const PlayerState> getState() const { return state.load(std::memory_order_acquire); }
+    
+    // Position of the audio currently audible, derived from the samples the
+    // output consumed minus what still sits in the output device's buffer
+    int64_t getPlayTimeMs() const;
+    int getPlayTime() const { return static_cast<int>(getPlayTimeMs() / 1000); }
     
-    bool isPlaying() const { return playing; }
-    bool isPaused() const { return paused; }
+    // Emulation runs ahead of the audio output by up to this much, which
+    // absorbs scheduling hiccups. Only takes effect before the first
+    // loadFile(), which starts the threads.
+    void setBufferLength(int milliseconds);
+    int getBufferLength() const;
+    size_t getBufferedSamples() const { return pcm_buffer->getReadable(); }
+    // Times the output found the buffer empty while playing, since the last load
+    uint64_t getUnderrunCount() const { return underruns; }
     
-    std::string getCurrentFile() const { return current_file; }
-    int getCurrentTrack() const { return current_track; }
-    int getTrackCount() const { return track_count; }
-    std::string getTitle() const { return title; }
-    std::string getAuthor() const { return author; }
-    std::string getCopyright() const { return copyright; }
-    int getPlayTime() const { return play_time; }
+    // Called from the audio thread when the play time reaches a new second,
+    // the position jumps, the queued tune starts or playback ends on its own,
+    // and from the preparer thread when a load finished or a tune cannot be
+    // prepared. Set before loadFile().
+    void setOnStateChange(std::function<void()> callback) { on_state_change = std::move(callback); }
+    // Consulted by the track changes and the preparer thread, so it has to be
+    // safe to call from both; a track needs a known length to be followed by
+    // the queued tune. Set before loadFile().
+    void setSongLengthLookup(SongLengthLookup lookup) { song_length_lookup = std::move(lookup); }
     
 private:
+    // Where the render thread switched to a queued tune, in ring positions
+    struct TrackBoundary {
+        size_t position = 0;
+        uint32_t discards = 0; // stale once the ring was discarded after this
+        uint64_t queue_id = 0;
+    };
+    
+    // A loadFile() or queueFile() call waiting for the preparer thread
+    struct PrepareRequest {
+        std::string filename;
+        int track = 0; // 0 for the tune's start song
+        uint64_t id = 0;
+    };
+    
+    std::unique_ptr<EngineSlot> prepareSlot(const std::string& filename, int track, PlayerState& info);
+    void requestPreparation(PrepareRequest& pending, bool& has_pending, PrepareRequest request);
+    void prepareThread();
+    void finishLoad(std::unique_ptr<EngineSlot> slot, PlayerState& info);
+    void collectRetiredSlots();
+    void recycleSlot(std::unique_ptr<EngineSlot> slot);
+    std::unique_ptr<EngineSlot> takeSpareSlot();
+    void retireSlot(std::unique_ptr<EngineSlot> slot);
+    uint64_t lookupLengthSamples(const std::string& filename, int track) const;
+    void selectTrack(int delta);
+    void post(PlayerCommand command);
+    void startThreads();
+    void renderThread();
     void audioThread();
-    void updatePlayTime();
+    void applyCommand(PlayerCommand& command);
+    void rewindTrack();
+    void startQueuedTrack();
+    void discardOutput(uint64_t start_sample);
+    void advanceToQueued(uint64_t queue_id);
+    void publishState();
+    void notifyStateChange();
     
-    std::unique_ptr<sidplayfp> engine;
-    std::unique_ptr<SidTune> tune;
-    class ReSIDfpBuilder* sid_builder;
+    // Changed by the controlling thread, by the preparer thread when a
+    // loaded or queued tune is ready and by the audio thread when the queued
+    // one starts;
+    // state_mutex only serializes these writers, readers of the published
+    // snapshot never take it
+    std::mutex state_mutex;
+    PlayerState control_state;
+    PlayerState queued_state; // becomes control_state when the queued tune starts
+    uint64_t queued_id;       // 0 if nothing is queued
+    uint64_t loading_id;      // 0 unless the preparer still has to load control_state.file
+    uint64_t last_request_id;
+    std::string failed_file;  // last queued tune that could not be prepared
+    int failed_track;
+    std::atomic<std::shared_ptr<const PlayerState>> state;
+    SongLengthLookup song_length_lookup;
     
-    std::string current_file;
-    int current_track;
-    int track_count;
-    std::string title;
-    std::string author;
-    std::string copyright;
+    // Owned by the render thread once handed over with a command
+    std::unique_ptr<EngineSlot> current;
+    std::unique_ptr<EngineSlot> next;
     
-    std::atomic<bool> playing;
-    std::atomic<bool> paused;
-    std::atomic<bool> should_stop;
-    std::atomic<int> play_time;
+    // Slots the render thread is done with go back to the preparer thread
+    // through retired_slots, which keeps a few of them warm. The spares and
+    // the tune cache belong to the preparer thread.
+    SpscQueue<std::unique_ptr<EngineSlot>, 8> retired_slots;
+    std::vector<std::unique_ptr<EngineSlot>> spare_slots;
+    SidTuneCache tune_cache;
+    bool rendering;            // play requested and not stopped
+    uint64_t render_position;  // samples emulated since the track started
+    uint64_t skip_until;       // seek target, emulated without output
     
+    SpscQueue<PlayerCommand, 32> commands;
+    SpscQueue<TrackBoundary, 8> boundaries; // render thread to audio thread
+    
+    // The render thread fills pcm_buffer up to high_water_mark samples, the
+    // audio thread drains it into PulseAudio
+    std::unique_ptr<PcmRingBuffer> pcm_buffer;
+    size_t high_water_mark;
+    std::atomic<bool> output_enabled;  // set by the render thread, the audio thread idles while false
+    std::atomic<bool> render_finished;
+    std::atomic<bool> should_quit;
+    std::atomic<uint64_t> output_start_sample; // track position of the first sample after the last discard
+    std::atomic<uint64_t> samples_played; // track position written to the output
+    std::atomic<uint32_t> output_latency_us; // queued in the output, last measured after a write
+    std::atomic<uint64_t> underruns;
+    
+    // Hands the latest loadFile() and queueFile() calls to the preparer thread
+    std::mutex request_mutex;
+    std::condition_variable request_ready;
+    PrepareRequest load_request;
+    PrepareRequest queue_request;
+    bool has_load_request;
+    bool has_queue_request;
+    bool quit_preparing;
+    
+    std::thread render_thread;
     std::thread audio_thread;
-    std::thread timer_thread;
+    std::thread prepare_thread;
+    
+    std::function<void()> on_state_change;
 };
\ No newline at end of file
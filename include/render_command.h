@@ -0,0 +1,11 @@
+#pragma once
+
+// "nancyplayer render": renders a subtune to a WAV or raw file without the
+// TUI or an audio device. Takes the arguments after the command name and
+// returns the process exit code.
+int runRenderCommand(int argc, char** argv);
+
+// "nancyplayer batch": renders every subtune of a directory tree, search
+// results or a list of files with one emulation per worker thread. Already
+// rendered files are skipped, so re-running an interrupted batch resumes it.
+int runBatchCommand(int argc, char** argv);
@@ -1,47 +1,114 @@
 #pragma once
 
+#include "catalog.h"
 #include <string>
+#include <string_view>
+#include <array>
 #include <vector>
-#include <map>
-#include <unordered_map>
+#include <memory>
+#include <functional>
+#include <cstdint>
 
-struct SongEntry {
-    std::string path;
-    std::string filename;
-    std::string title;
-    std::string artist;
-    std::vector<int> lengths; // lengths for each subtune in seconds
-    std::string md5;
+enum class SearchMode {
+    Substring, // query must occur verbatim in filename, title or artist
+    Fuzzy      // query characters must occur in order in path, title or artist
+};
+
+// State kept between keystrokes of search-as-you-type. When a query extends
+// the previous one, only the previous matches need to be checked again.
+struct SearchSession {
+    const Catalog* catalog = nullptr;
+    SearchMode mode = SearchMode::Substring;
+    std::string lower_query;       // query that produced matches
+    std::vector<uint32_t> matches; // catalog song ids, ascending
     
-    std::string getDisplayName() const {
-        if (!title.empty() && !artist.empty()) {
-            return artist + " - " + title;
-        } else if (!title.empty()) {
-            return title;
-        } else {
-            return filename;
-        }
+    void reset() {
+        catalog = nullptr;
+        lower_query.clear();
+        matches.clear();
     }
 };
 
+// One page of ranked matches. total_matches counts every match, including
+// those beyond the result limit that were not ranked into entries.
+struct SearchResults {
+    std::vector<SongEntry> entries;
+    size_t total_matches = 0;
+};
+
+// Hooks for running a search in the background. should_cancel is polled
+// between batches of candidates; on_partial receives the ranked matches
+// found so far while the search is still running.
+struct SearchProgress {
+    std::function<bool()> should_cancel;
+    std::function<void(SearchResults&&)> on_partial;
+};
+
 class Search {
 public:
     Search();
     
-    bool loadDatabase(const std::string& hvsc_root);
-    std::vector<SongEntry> search(const std::string& query) const;
-    SongEntry getSongInfo(const std::string& sid_file_path) const;
-    bool hasSongInfo(const std::string& sid_file_path) const;
+    void setCatalog(std::shared_ptr<const Catalog> catalog);
+    SearchResults search(const std::string& query) const;
+    SearchResults search(const std::string& query, SearchSession& session) const;
+    SearchResults search(const std::string& query, SearchSession& session, const SearchProgress& progress,
+                         SearchMode mode = SearchMode::Substring) const;
+    void setResultLimit(size_t limit) { result_limit = limit; } // 0 means unlimited
+    // Entries point into the catalog and stay valid while it is set; null if unknown
+    const SongEntry* findSongInfo(const std::string& sid_file_path) const;
+    const SongEntry* findSongInfoByHvscPath(std::string_view hvsc_path) const;
     int getSongLength(const std::string& sid_file_path, int track = 1) const;
-    size_t getEntryCount() const { return song_entries.size(); }
+    // Same as getSongLength for a catalog key like FileEntry::hvsc_path, without touching the filesystem
+    int getSongLengthByHvscPath(std::string_view hvsc_path, int track = 1) const;
+    size_t getEntryCount() const { return catalog ? catalog->getSongCount() : 0; }
     
 private:
-    void parseSonglengthsFile(const std::string& songlengths_file_path);
-    void parseStilFile(const std::string& stil_file_path);
-    void indexLocalSidFiles(const std::string& directory);
-    std::string normalizePathForLookup(const std::string& sid_file_path) const;
+    void buildIndex();
+    std::vector<uint32_t> findCandidates(const std::string& lower_query) const;
+    std::vector<uint32_t> allSongIds() const;
+    bool verifyCandidates(const std::vector<uint32_t>& candidates, const std::string& lower_query,
+                          std::vector<uint32_t>& matches, const SearchProgress& progress) const;
+    struct FuzzyFields;
+    std::string_view songText(uint32_t id) const;
+    // Artist, title and filename of a song's text
+    static std::array<std::string_view, 3> substringFields(std::string_view text, const FuzzyFields& fields);
+    int scoreFuzzy(uint32_t id, const std::string& pattern) const;
+    bool scoreFuzzyCandidates(const std::vector<uint32_t>& candidates, const std::string& pattern,
+                              std::vector<uint32_t>& matches, std::vector<uint32_t>& scores,
+                              const SearchProgress& progress) const;
+    uint64_t rankKey(uint32_t id, uint32_t relevance) const;
+    uint32_t substringRelevance(uint32_t id, const std::string& lower_query) const;
+    // Merges a batch's keys into page, the sorted top result_limit keys, and publishes it
+    void publishPartial(std::vector<uint64_t>& page, std::vector<uint64_t>& batch_keys, size_t total_matches,
+                        const SearchProgress& progress) const;
+    SearchResults pageResults(const std::vector<uint64_t>& sorted_keys, size_t total_matches) const;
+    SearchResults rankResults(const std::vector<uint32_t>& matches, const std::vector<uint32_t>& scores,
+                              const std::string& lower_query) const;
+    
+    std::shared_ptr<const Catalog> catalog;
+    std::vector<uint32_t> display_ranks;   // position of each song in folded display-name order
+    std::vector<uint32_t> display_order;   // inverse of display_ranks
+    size_t result_limit;
+    
+    // Text column: lowercased "artist composer title path" of every song
+    // packed into one buffer, song id's text at [fuzzy_offsets[id], fuzzy_offsets[id + 1]).
+    // Fuzzy matching reads it whole, substring search its artist, title and
+    // filename fields.
+    std::string fuzzy_column;
+    std::vector<uint32_t> fuzzy_offsets;
+    // Where the artist, the title and the filename sit inside each song's text
+    struct FuzzyFields {
+        uint32_t artist_end;
+        uint32_t title_begin;
+        uint32_t title_end;
+        uint32_t filename_begin;
+    };
+    std::vector<FuzzyFields> fuzzy_fields;
+    std::vector<uint32_t> fuzzy_masks; // fuzzy::charMask of each song's text
     
-    std::unordered_map<std::string, SongEntry> song_entries; // keyed by normalized path
-    std::unordered_map<std::string, std::string> md5_to_path; // MD5 to path mapping
-    std::string hvsc_root_path;
+    // Trigram inverted index in CSR layout: songs containing trigram_keys[i] are
+    // trigram_postings[trigram_offsets[i] .. trigram_offsets[i + 1]), sorted by id
+    std::vector<uint32_t> trigram_keys;
+    std::vector<uint32_t> trigram_offsets;
+    std::vector<uint32_t> trigram_postings;
 };
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "search.h"
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <functional>
+
+// Runs Search queries on a background thread so typing never waits for a
+// query. Submitting a new query cancels the one in flight; results (partial
+// while running, then final) are picked up by the UI with poll().
+class SearchWorker {
+public:
+    SearchWorker();
+    ~SearchWorker();
+    SearchWorker(const SearchWorker&) = delete;
+    SearchWorker& operator=(const SearchWorker&) = delete;
+    
+    void setSearch(std::shared_ptr<const Search> search);
+    // Called on the worker thread whenever poll() or isBusy() would change,
+    // so the UI can sleep instead of polling. Must not call back into the worker.
+    void setOnUpdate(std::function<void()> callback);
+    void submit(const std::string& query, SearchMode mode = SearchMode::Substring);
+    void cancel();
+    bool poll(SearchResults& results);
+    bool isBusy() const { return busy; }
+    
+private:
+    void workerLoop();
+    void publish(uint64_t for_generation, SearchResults&& results);
+    
+    SearchSession session; // only used by the worker thread
+    
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::shared_ptr<const Search> search; // swapped between queries, never during one
+    std::string pending_query;
+    SearchMode pending_mode;
+    bool has_pending;
+    bool running;
+    bool stopping;
+    std::atomic<uint64_t> generation; // bumped on every submit/cancel
+    std::atomic<bool> busy; // has_pending || running, readable without the lock
+    
+    SearchResults published;
+    bool has_update;
+    std::function<void()> on_update;
+};
\ No newline at end of file
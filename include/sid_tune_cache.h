@@ -0,0 +1,40 @@
+#pragma once
+
+#include "index_cache.h"
+#include <string>
+#include <memory>
+#include <list>
+#include <unordered_map>
+#include <sidplayfp/SidTune.h>
+
+// Parsed SidTunes of recently played files, least recently used dropped
+// first. A SidTune remembers its selected subtune, so a tune is never shared:
+// take() hands it out and removes it from the cache, put() returns it once
+// its engine let go of it. A cached tune is only reused while its file still
+// matches the stamp it was parsed from.
+class SidTuneCache {
+public:
+    explicit SidTuneCache(size_t capacity = 16);
+    SidTuneCache(const SidTuneCache&) = delete;
+    SidTuneCache& operator=(const SidTuneCache&) = delete;
+    
+    // Returns the cached tune for path, or maps and parses the file. stamp is
+    // set to the file's stamp to hand back to put(). Null if the file cannot
+    // be read or is no tune.
+    std::unique_ptr<SidTune> take(const std::string& path, SourceStamp& stamp);
+    void put(const std::string& path, const SourceStamp& stamp, std::unique_ptr<SidTune> tune);
+    
+    size_t size() const { return entries.size(); }
+    void clear();
+    
+private:
+    struct Entry {
+        std::string path;
+        SourceStamp stamp;
+        std::unique_ptr<SidTune> tune;
+    };
+    
+    size_t capacity;
+    std::list<Entry> entries; // most recently returned first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Lock-free single-producer/single-consumer queue of at most Capacity
+// elements. The producer only calls push(), the consumer only calls pop();
+// like PcmRingBuffer, positions are free-running counters published with
+// release/acquire ordering. Popped slots keep a moved-from element until
+// they are reused.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    
+public:
+    SpscQueue() : write_pos(0), read_pos(0) {}
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+    
+    // Producer only. Leaves value untouched and returns false when full.
+    bool push(T&& value) {
+        size_t write_index = write_pos.load(std::memory_order_relaxed);
+        if (write_index - read_pos.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        slots[write_index & (Capacity - 1)] = std::move(value);
+        write_pos.store(write_index + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer only
+    bool pop(T& value) {
+        size_t read_index = read_pos.load(std::memory_order_relaxed);
+        if (read_index == write_pos.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(slots[read_index & (Capacity - 1)]);
+        read_pos.store(read_index + 1, std::memory_order_release);
+        return true;
+    }
+    
+    bool empty() const {
+        return read_pos.load(std::memory_order_acquire) == write_pos.load(std::memory_order_acquire);
+    }
+    
+private:
+    std::array<T, Capacity> slots;
+    
+    // Kept on separate cache lines so producer and consumer do not contend
+    alignas(64) std::atomic<size_t> write_pos;
+    alignas(64) std::atomic<size_t> read_pos;
+};
@@ -1,30 +1,23 @@
 #pragma once
 
+#include "catalog.h"
 #include <string>
-#include <map>
-#include <vector>
-
-struct StilEntry {
-    std::string title;
-    std::string artist;
-    std::string comment;
-    std::string copyright;
-    std::vector<std::string> subtune_info;
-};
+#include <string_view>
+#include <memory>
 
 class StilReader {
 public:
     StilReader();
     
-    bool loadDatabase(const std::string& hvsc_root);
-    StilEntry getInfo(const std::string& sid_file_path) const;
-    bool hasInfo(const std::string& sid_file_path) const;
-    size_t getEntryCount() const { return stil_entries.size(); }
+    void setCatalog(std::shared_ptr<const Catalog> catalog);
     
-private:
-    void parseStilFile(const std::string& stil_file_path);
-    std::string normalizePathForStil(const std::string& sid_file_path) const;
+    // Entries point into the catalog and stay valid until the next setCatalog().
+    // Returns null if the file has no STIL entry or no catalog is loaded.
+    const StilEntry* findInfo(const std::string& sid_file_path) const;
+    // Same for a catalog key like FileEntry::hvsc_path, without touching the filesystem
+    const StilEntry* findInfoByHvscPath(std::string_view hvsc_path) const;
+    size_t getEntryCount() const { return catalog ? catalog->getStilCount() : 0; }
     
-    std::map<std::string, StilEntry> stil_entries;
-    std::string hvsc_root_path;
+private:
+    std::shared_ptr<const Catalog> catalog;
 };
\ No newline at end of file
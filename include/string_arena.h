@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <unordered_set>
+#include <cstddef>
+
+// Append-only storage for many small strings. Strings are packed into large
+// blocks and never move, so the returned views stay valid for the arena's
+// lifetime, including after the arena itself is moved.
+class StringArena {
+public:
+    explicit StringArena(size_t block_size = 256 * 1024);
+    StringArena(StringArena&&) = default;
+    StringArena& operator=(StringArena&&) = default;
+    
+    std::string_view store(std::string_view text);
+    void adopt(StringArena&& other); // takes over other's blocks, its views stay valid
+    void clear(); // invalidates every view handed out so far
+    size_t getBytesAllocated() const { return bytes_allocated; }
+    
+private:
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t block_size;
+    size_t block_used;
+    size_t bytes_allocated;
+};
+
+// Deduplicates strings that repeat a lot (like artist names) on top of an arena.
+class StringInterner {
+public:
+    explicit StringInterner(StringArena& arena) : arena(arena) {}
+    
+    std::string_view intern(std::string_view text);
+    size_t getUniqueCount() const { return pool.size(); }
+    void clear() { pool.clear(); }
+    
+private:
+    StringArena& arena;
+    std::unordered_set<std::string_view> pool;
+};
\ No newline at end of file
@@ -2,15 +2,24 @@
 
 #include <ncurses.h>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
 
 class Player;
 class FileBrowser;
 class StilReader;
 class Search;
+class SearchWorker;
+class Catalog;
 class Config;
+class EventLoop;
+class EventNotifier;
 
 class TUI {
 public:
@@ -23,6 +32,19 @@ public:
     void handleResize();
     
 private:
+    // Screen regions that changed since the last refresh(); only these are redrawn
+    enum DirtyRegion : unsigned {
+        DIRTY_HEADER    = 1u << 0,
+        DIRTY_BROWSER   = 1u << 1,
+        DIRTY_SEPARATOR = 1u << 2,
+        DIRTY_INFO      = 1u << 3,
+        DIRTY_STATUS    = 1u << 4,
+        DIRTY_HELP      = 1u << 5,
+        DIRTY_SEARCH    = 1u << 6,
+        DIRTY_ALL       = (1u << 7) - 1
+    };
+    
+    void markDirty(unsigned regions) { dirty |= regions; }
     void initWindows();
     void destroyWindows();
     void initColors();
@@ -33,11 +55,19 @@ private:
     void drawStatus();
     void drawHelp();
     void drawSearchResults();
+    void pollSearchResults();
+    void startDatabaseLoader();
+    void pollDatabaseLoader();
+    void pollPlayerState();
+    void startPlayback(const std::string& path, const std::string& hvsc_path);
+    void queueNextTune();
+    void handleKey(int ch);
     void drawSeparator();
     void resetScrollPositions();
     void createSearchWindow();
     void destroySearchWindow();
-    std::string cropTextLeft(const std::string& text, int max_width);
+    std::string cropTextLeft(std::string_view text, int max_width);
+    void printCroppedLeft(WINDOW* win, int y, int x, std::string_view text, int max_width);
     
     WINDOW* header_win;
     WINDOW* browser_win;
@@ -47,16 +77,48 @@ private:
     WINDOW* help_win;
     WINDOW* search_win;
     
+    // Declared first so they outlive the threads that notify them
+    std::unique_ptr<EventLoop> events;
+    std::unique_ptr<EventNotifier> wakeup; // player and workers signal state changes here
+    
     std::unique_ptr<Player> player;
     std::unique_ptr<FileBrowser> browser;
     std::unique_ptr<StilReader> stil_reader;
-    std::unique_ptr<Search> search;
+    std::shared_ptr<Search> search;
+    std::atomic<std::shared_ptr<const Search>> length_search; // search for the player's threads
+    std::unique_ptr<SearchWorker> search_worker;
     std::unique_ptr<Config> config;
     
+    // Background database loading; guarded by loader_mutex until handed over
+    std::thread loader_thread;
+    std::mutex loader_mutex;
+    std::string loader_stage;
+    int loader_percent;
+    unsigned loader_updates; // bumped with every progress report
+    std::shared_ptr<Catalog> loaded_catalog;
+    std::shared_ptr<Search> loaded_search;
+    bool database_ready; // main thread only
+    unsigned shown_loader_updates;
+    
+    std::string playing_hvsc_path; // catalog key of the loaded file, set when loading it
+    // SID files of the directory playback was started in. Once the last
+    // subtune of a file is queued, the next file here follows it gaplessly.
+    std::vector<struct FileEntry> playlist;
+    int playlist_index; // of the playing file, -1 if not in the playlist
+    
+    // What the screen currently shows, compared every loop to find out what to redraw
+    unsigned dirty;
+    std::shared_ptr<const struct PlayerState> shown_state;
+    int shown_play_time;
+    uint64_t shown_underruns;
+    bool shown_search_busy;
+    
     bool running;
     bool search_mode;
+    bool search_fuzzy;
     std::string search_query;
     std::vector<struct SongEntry> search_results;
+    size_t search_total_matches;
     int search_selected;
     int screen_height;
     int screen_width;
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Runs a fixed set of tasks on a fixed number of threads. Tasks are dealt out
+// round-robin up front; each worker runs its own share from the front, and
+// once it is out of work it steals from the back of another worker's share.
+// With task lengths that differ by orders of magnitude this keeps every
+// thread busy until the last few tasks, without a central queue.
+//
+// Tasks are expected to run for milliseconds or more, so each share is a
+// plain deque behind its own mutex; the lock is only contended while stealing.
+class WorkStealingPool {
+public:
+    // Called with the task index and the index of the worker running it
+    using Task = std::function<void(size_t task, int worker)>;
+    
+    explicit WorkStealingPool(int thread_count);
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+    
+    // Runs tasks 0..task_count-1 and returns when all are done. Tasks with a
+    // low index start first, so callers can order them longest first.
+    void run(size_t task_count, const Task& task);
+    
+    int getThreadCount() const { return static_cast<int>(shares.size()); }
+    size_t getStealCount() const { return steals.load(std::memory_order_relaxed); }
+
+private:
+    struct Share {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+    
+    bool popOwn(int worker, size_t& task);
+    bool steal(int worker, size_t& task);
+    void workerLoop(int worker, const Task& task);
+    
+    std::vector<std::unique_ptr<Share>> shares;
+    std::atomic<size_t> steals;
+};
@@ -0,0 +1,672 @@
+#include "catalog.h"
+#include "index_cache.h"
+#include "mapped_file.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <cstring>
+
+size_t Md5DigestHash::operator()(const Md5Digest& digest) const {
+    // Digests are uniformly distributed already, any 8 bytes make a good hash
+    size_t hash;
+    std::memcpy(&hash, digest.data(), sizeof(hash));
+    return hash;
+}
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool parseMd5Digest(std::string_view hex, Md5Digest& digest) {
+    if (hex.size() != digest.size() * 2) {
+        return false;
+    }
+    for (size_t i = 0; i < digest.size(); i++) {
+        int high = hexDigit(hex[i * 2]);
+        int low = hexDigit(hex[i * 2 + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        digest[i] = static_cast<uint8_t>(high << 4 | low);
+    }
+    return true;
+}
+
+std::string formatMd5Digest(const Md5Digest& digest) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(digest.size() * 2);
+    for (uint8_t byte : digest) {
+        hex.push_back(digits[byte >> 4]);
+        hex.push_back(digits[byte & 0x0f]);
+    }
+    return hex;
+}
+
+// Returns the first existing candidate of an HVSC document, or "" if none
+static std::string findDocument(const std::string& hvsc_root, const std::string& name) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    
+    std::vector<std::string> candidates = {
+        hvsc_root + "/DOCUMENTS/" + name,
+        hvsc_root + "/" + name,
+        hvsc_root + "/documents/" + name,
+        hvsc_root + "/" + lower
+    };
+    
+    // Canonical, so the index cache recognizes the same file by any spelling
+    // of the root and notices when another one is found instead
+    for (const auto& path : candidates) {
+        std::error_code error;
+        std::string canonical = std::filesystem::canonical(path, error).string();
+        if (!error) {
+            return canonical;
+        }
+    }
+    return "";
+}
+
+Catalog::Catalog() : artists(arena) {
+}
+
+bool Catalog::load(const std::string& hvsc_root, const std::string& cache_dir,
+                   const CatalogProgressCallback& on_progress) {
+    progress_callback = on_progress;
+    
+    try {
+        hvsc_root_path = std::filesystem::canonical(hvsc_root).string();
+    } catch (const std::filesystem::filesystem_error& e) {
+        hvsc_root_path = hvsc_root;
+    }
+    
+    std::string songlengths_path = findDocument(hvsc_root_path, "Songlengths.md5");
+    std::string stil_path = findDocument(hvsc_root_path, "STIL.txt");
+    
+    // The index depends on both files, so either one changing triggers a rebuild
+    std::vector<std::string> source_paths;
+    if (!songlengths_path.empty()) source_paths.push_back(songlengths_path);
+    if (!stil_path.empty()) source_paths.push_back(stil_path);
+    
+    if (source_paths.empty()) {
+        progress_callback = nullptr;
+        return false;
+    }
+    
+    std::string cache_path = cache_dir.empty() ? "" : cache_dir + "/catalog.idx";
+    reportProgress("Reading index cache", 0);
+    if (!cache_path.empty() && loadIndexCache(cache_path, source_paths)) {
+        reportProgress("Index cache loaded", 100);
+        progress_callback = nullptr;
+        return true;
+    }
+    
+    // Rough split of a full parse: Songlengths 0-40%, STIL 40-90%, cache 90-100%
+    if (!songlengths_path.empty()) {
+        reportProgress("Parsing Songlengths.md5", 0);
+        parseSonglengthsFile(songlengths_path);
+    }
+    if (!stil_path.empty()) {
+        reportProgress("Parsing STIL.txt", 40);
+        parseStilFile(stil_path);
+    }
+    finalize();
+    
+    if (!cache_path.empty()) {
+        reportProgress("Writing index cache", 90);
+        saveIndexCache(cache_path, source_paths);
+    }
+    
+    reportProgress("Database loaded", 100);
+    progress_callback = nullptr;
+    return true;
+}
+
+bool Catalog::loadDocument(const std::string& hvsc_root, const std::string& name) {
+    clear();
+    std::error_code error;
+    std::filesystem::path root = std::filesystem::canonical(hvsc_root, error);
+    hvsc_root_path = error ? hvsc_root : root.string();
+    
+    std::string path = findDocument(hvsc_root_path, name);
+    if (path.empty()) {
+        return false;
+    }
+    if (name == "Songlengths.md5") {
+        parseSonglengthsFile(path);
+    } else if (name == "STIL.txt") {
+        parseStilFile(path);
+    } else {
+        return false;
+    }
+    finalize();
+    return true;
+}
+
+void Catalog::reportProgress(const char* stage, int percent) const {
+    if (progress_callback) {
+        progress_callback(stage, percent);
+    }
+}
+
+const SongEntry* Catalog::findSong(std::string_view hvsc_path) const {
+    auto it = song_index.find(hvsc_path);
+    return it != song_index.end() ? &songs[it->second] : nullptr;
+}
+
+const SongEntry* Catalog::findSongByMd5(const Md5Digest& md5) const {
+    auto it = md5_index.find(md5);
+    return it != md5_index.end() ? &songs[it->second] : nullptr;
+}
+
+const StilEntry* Catalog::findStil(std::string_view hvsc_path) const {
+    auto it = stil_index.find(hvsc_path);
+    return it != stil_index.end() ? &stil_entries[it->second] : nullptr;
+}
+
+template <typename Map>
+static size_t hashMapMemoryUsage(const Map& map) {
+    // Node-based: one bucket pointer each plus a node holding the value, the
+    // next pointer and the cached hash
+    return map.bucket_count() * sizeof(void*) +
+           map.size() * (sizeof(typename Map::value_type) + 2 * sizeof(void*));
+}
+
+size_t Catalog::getMemoryUsage() const {
+    return arena.getBytesAllocated() +
+           songs.capacity() * sizeof(SongEntry) +
+           song_lengths.capacity() * sizeof(int) +
+           stil_entries.capacity() * sizeof(StilEntry) +
+           stil_subtunes.capacity() * sizeof(std::string_view) +
+           hashMapMemoryUsage(song_index) +
+           hashMapMemoryUsage(md5_index) +
+           hashMapMemoryUsage(stil_index);
+}
+
+// entry.path must already live in the arena
+void Catalog::addSong(const SongEntry& entry, Range lengths) {
+    auto it = song_index.find(entry.path);
+    uint32_t id;
+    if (it != song_index.end()) {
+        id = it->second;
+        songs[id] = entry;
+        song_length_ranges[id] = lengths;
+    } else {
+        id = static_cast<uint32_t>(songs.size());
+        song_index.emplace(entry.path, id);
+        songs.push_back(entry);
+        song_length_ranges.push_back(lengths);
+    }
+    
+    if (entry.md5 != Md5Digest{}) {
+        md5_index[entry.md5] = id;
+    }
+}
+
+// hvsc_path and all strings of entry must already live in the arena
+void Catalog::addStil(std::string_view hvsc_path, const StilEntry& entry, Range subtunes) {
+    auto it = stil_index.find(hvsc_path);
+    if (it != stil_index.end()) {
+        stil_entries[it->second] = entry;
+        stil_subtune_ranges[it->second] = subtunes;
+    } else {
+        stil_index.emplace(hvsc_path, static_cast<uint32_t>(stil_entries.size()));
+        stil_entries.push_back(entry);
+        stil_subtune_ranges.push_back(subtunes);
+    }
+}
+
+void Catalog::finalize() {
+    song_lengths.shrink_to_fit();
+    stil_subtunes.shrink_to_fit();
+    songs.shrink_to_fit();
+    stil_entries.shrink_to_fit();
+    
+    for (size_t i = 0; i < stil_entries.size(); i++) {
+        Range range = stil_subtune_ranges[i];
+        stil_entries[i].subtune_info = std::span<const std::string_view>(stil_subtunes.data() + range.begin, range.count);
+    }
+    for (size_t i = 0; i < songs.size(); i++) {
+        Range range = song_length_ranges[i];
+        songs[i].lengths = std::span<const int>(song_lengths.data() + range.begin, range.count);
+        songs[i].stil = findStil(songs[i].path);
+    }
+    
+    song_length_ranges = std::vector<Range>();
+    stil_subtune_ranges = std::vector<Range>();
+}
+
+void Catalog::clear() {
+    songs.clear();
+    song_length_ranges.clear();
+    song_lengths.clear();
+    song_index.clear();
+    md5_index.clear();
+    stil_entries.clear();
+    stil_subtune_ranges.clear();
+    stil_subtunes.clear();
+    stil_index.clear();
+    artists.clear();
+    arena.clear();
+}
+
+// Parses one "m:ss" or "m:ss.mmm" length at p without allocating and
+// advances p past it. Returns seconds, or -1 if p does not hold a length.
+static int parseLength(const char*& p, const char* end) {
+    int minutes = 0;
+    const char* digits_start = p;
+    while (p < end && *p >= '0' && *p <= '9') {
+        minutes = minutes * 10 + (*p++ - '0');
+    }
+    if (p == digits_start || p >= end || *p != ':') {
+        return -1;
+    }
+    p++;
+    
+    int seconds = 0;
+    digits_start = p;
+    while (p < end && *p >= '0' && *p <= '9') {
+        seconds = seconds * 10 + (*p++ - '0');
+    }
+    if (p == digits_start) {
+        return -1;
+    }
+    
+    // Milliseconds and attribute suffixes like "(G)" are dropped
+    while (p < end && *p != ' ' && *p != '\t') {
+        p++;
+    }
+    return minutes * 60 + seconds;
+}
+
+// Songs of one Songlengths.md5 chunk. Paths live in the chunk's own arena and
+// lengths are stored back to back, length_counts[i] of them for songs[i].
+struct SonglengthsChunk {
+    StringArena arena{64 * 1024};
+    std::vector<SongEntry> songs;
+    std::vector<uint32_t> length_counts;
+    std::vector<int> lengths;
+};
+
+// Parses Songlengths.md5 lines in [begin, end). begin must be the start of a
+// "; /path" line (or of the file) so each chunk knows the path of its entries.
+static void parseSonglengthsChunk(const char* begin, const char* end, SonglengthsChunk& out) {
+    std::string_view current_path;
+    std::string_view stored_path; // current_path copied into the arena, once used
+    const char* p = begin;
+    
+    while (p < end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!eol) {
+            eol = end;
+        }
+        std::string_view line(p, eol - p);
+        p = eol < end ? eol + 1 : end;
+        
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.empty()) {
+            continue;
+        }
+        
+        // Comment lines carry the path of the following entry: "; /DEMOS/0-9/10_Orbyte.sid"
+        if (line[0] == ';') {
+            size_t path_start = line.find('/');
+            if (path_start != std::string_view::npos) {
+                current_path = line.substr(path_start);
+                size_t last = current_path.find_last_not_of(" \t");
+                current_path = current_path.substr(0, last + 1);
+                stored_path = std::string_view();
+            }
+            continue;
+        }
+        
+        // MD5=length [length ...], one length per subtune
+        size_t equals_pos = line.find('=');
+        if (equals_pos == std::string_view::npos || current_path.empty()) {
+            continue;
+        }
+        
+        if (stored_path.empty()) {
+            stored_path = out.arena.store(current_path);
+        }
+        
+        SongEntry entry;
+        entry.path = stored_path;
+        entry.filename = stored_path.substr(stored_path.find_last_of('/') + 1);
+        parseMd5Digest(line.substr(0, equals_pos), entry.md5);
+        
+        size_t lengths_before = out.lengths.size();
+        const char* q = line.data() + equals_pos + 1;
+        const char* line_end = line.data() + line.size();
+        while (q < line_end) {
+            while (q < line_end && (*q == ' ' || *q == '\t')) {
+                q++;
+            }
+            if (q >= line_end) {
+                break;
+            }
+            int length = parseLength(q, line_end);
+            if (length < 0) {
+                break;
+            }
+            out.lengths.push_back(length);
+        }
+        
+        out.songs.push_back(entry);
+        out.length_counts.push_back(static_cast<uint32_t>(out.lengths.size() - lengths_before));
+    }
+}
+
+void Catalog::parseSonglengthsFile(const std::string& songlengths_file_path) {
+    MappedFile file;
+    if (!file.open(songlengths_file_path)) {
+        return;
+    }
+    
+    const char* data = file.getData();
+    const char* data_end = data + file.getSize();
+    
+    // Split into one chunk per core, moving each cut forward to the next
+    // "; /path" line. Small files are not worth the thread start-up.
+    const size_t min_chunk_size = 256 * 1024;
+    size_t thread_count = std::max(1u, std::thread::hardware_concurrency());
+    thread_count = std::max<size_t>(1, std::min(thread_count, file.getSize() / min_chunk_size));
+    
+    std::vector<const char*> cuts = {data};
+    std::string_view text = file.view();
+    for (size_t i = 1; i < thread_count; i++) {
+        size_t pos = std::max<size_t>(i * file.getSize() / thread_count, cuts.back() - data);
+        while (pos != std::string_view::npos) {
+            pos = text.find("\n;", pos);
+            if (pos == std::string_view::npos) {
+                break;
+            }
+            size_t line_end = text.find('\n', pos + 1);
+            std::string_view line = text.substr(pos + 1, line_end == std::string_view::npos ? std::string_view::npos : line_end - pos - 1);
+            if (line.find('/') != std::string_view::npos) {
+                break;
+            }
+            pos++;
+        }
+        if (pos == std::string_view::npos) {
+            break;
+        }
+        cuts.push_back(data + pos + 1);
+    }
+    cuts.push_back(data_end);
+    
+    std::vector<SonglengthsChunk> chunks(cuts.size() - 1);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < chunks.size(); i++) {
+        workers.emplace_back(parseSonglengthsChunk, cuts[i], cuts[i + 1], std::ref(chunks[i]));
+    }
+    parseSonglengthsChunk(cuts[0], cuts[1], chunks[0]);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    // Merge in file order so later duplicates still win, as with a serial parse
+    size_t total_songs = 0;
+    size_t total_lengths = 0;
+    for (const auto& chunk : chunks) {
+        total_songs += chunk.songs.size();
+        total_lengths += chunk.lengths.size();
+    }
+    songs.reserve(songs.size() + total_songs);
+    song_length_ranges.reserve(song_length_ranges.size() + total_songs);
+    song_lengths.reserve(song_lengths.size() + total_lengths);
+    song_index.reserve(song_index.size() + total_songs);
+    md5_index.reserve(md5_index.size() + total_songs);
+    for (auto& chunk : chunks) {
+        arena.adopt(std::move(chunk.arena));
+        uint32_t next_length = static_cast<uint32_t>(song_lengths.size());
+        song_lengths.insert(song_lengths.end(), chunk.lengths.begin(), chunk.lengths.end());
+        for (size_t i = 0; i < chunk.songs.size(); i++) {
+            addSong(chunk.songs[i], Range{next_length, chunk.length_counts[i]});
+            next_length += chunk.length_counts[i];
+        }
+    }
+}
+
+void Catalog::parseStilFile(const std::string& stil_file_path) {
+    std::ifstream file(stil_file_path);
+    if (!file.is_open()) {
+        return;
+    }
+    
+    std::string line;
+    std::string current_file;
+    StilEntry current_entry;
+    std::vector<std::string> comment_lines;
+    
+    file.seekg(0, std::ios::end);
+    std::streamoff file_size = std::max<std::streamoff>(1, file.tellg());
+    file.seekg(0, std::ios::beg);
+    size_t line_count = 0;
+    
+    uint32_t subtunes_begin = 0;
+    
+    auto saveCurrentEntry = [&]() {
+        if (!current_file.empty()) {
+            // Join comment lines with spaces
+            if (!comment_lines.empty()) {
+                std::ostringstream comment_stream;
+                for (size_t i = 0; i < comment_lines.size(); ++i) {
+                    if (i > 0) comment_stream << " ";
+                    comment_stream << comment_lines[i];
+                }
+                current_entry.comment = arena.store(comment_stream.str());
+            }
+            uint32_t subtunes_end = static_cast<uint32_t>(stil_subtunes.size());
+            addStil(arena.store(current_file), current_entry, Range{subtunes_begin, subtunes_end - subtunes_begin});
+        }
+    };
+    
+    while (std::getline(file, line)) {
+        if (progress_callback && ++line_count % 8192 == 0) {
+            reportProgress("Parsing STIL.txt", 40 + static_cast<int>(50 * file.tellg() / file_size));
+        }
+        
+        // Remove carriage return (Windows line endings)
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        
+        // Skip empty lines and comments starting with #
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        
+        // Check if this is a file path line (starts with /)
+        if (line[0] == '/') {
+            // Save previous entry
+            saveCurrentEntry();
+            
+            // Start new entry
+            current_file = line;
+            current_entry = StilEntry{};
+            comment_lines.clear();
+            subtunes_begin = static_cast<uint32_t>(stil_subtunes.size());
+        }
+        else if (!current_file.empty()) {
+            // Parse field lines - look for patterns with colons
+            size_t colon_pos = line.find(':');
+            if (colon_pos != std::string::npos) {
+                std::string field_name = line.substr(0, colon_pos);
+                std::string field_value = line.substr(colon_pos + 1);
+                
+                // Trim leading/trailing spaces and carriage returns from field name and value
+                field_name.erase(0, field_name.find_first_not_of(" \t\r"));
+                field_name.erase(field_name.find_last_not_of(" \t\r") + 1);
+                field_value.erase(0, field_value.find_first_not_of(" \t\r"));
+                field_value.erase(field_value.find_last_not_of(" \t\r") + 1);
+                
+                if (field_name == "TITLE") {
+                    current_entry.title = arena.store(field_value);
+                }
+                else if (field_name == "ARTIST") {
+                    current_entry.artist = artists.intern(field_value);
+                }
+                else if (field_name == "COPYRIGHT") {
+                    current_entry.copyright = arena.store(field_value);
+                }
+                else if (field_name == "COMMENT") {
+                    comment_lines.clear();
+                    comment_lines.push_back(field_value);
+                }
+            }
+            else if (!comment_lines.empty() && line.find_first_not_of(' ') != std::string::npos) {
+                // This is a continuation line for a comment
+                std::string trimmed = line;
+                trimmed.erase(0, trimmed.find_first_not_of(" \t\r"));
+                trimmed.erase(trimmed.find_last_not_of(" \t\r") + 1);
+                comment_lines.push_back(trimmed);
+            }
+            else if (line.find("(#") != std::string::npos) {
+                // Subtune information
+                stil_subtunes.push_back(arena.store(line));
+            }
+        }
+    }
+    
+    // Save last entry
+    saveCurrentEntry();
+}
+
+bool Catalog::loadIndexCache(const std::string& cache_path, const std::vector<std::string>& source_paths) {
+    IndexCacheReader reader;
+    if (!reader.open(cache_path, "catalog", source_paths)) {
+        return false;
+    }
+    
+    uint32_t stil_count = 0;
+    reader.readU32(stil_count);
+    stil_entries.reserve(stil_count);
+    stil_subtune_ranges.reserve(stil_count);
+    stil_index.reserve(stil_count);
+    for (uint32_t i = 0; i < stil_count && reader.ok(); i++) {
+        std::string_view path, title, artist, comment, copyright;
+        uint32_t subtune_count = 0;
+        reader.readString(path);
+        reader.readString(title);
+        reader.readString(artist);
+        reader.readString(comment);
+        reader.readString(copyright);
+        reader.readU32(subtune_count);
+        
+        StilEntry entry;
+        entry.title = arena.store(title);
+        entry.artist = artists.intern(artist);
+        entry.comment = arena.store(comment);
+        entry.copyright = arena.store(copyright);
+        Range subtunes{static_cast<uint32_t>(stil_subtunes.size()), subtune_count};
+        for (uint32_t j = 0; j < subtune_count && reader.ok(); j++) {
+            std::string_view subtune;
+            reader.readString(subtune);
+            stil_subtunes.push_back(arena.store(subtune));
+        }
+        addStil(arena.store(path), entry, subtunes);
+    }
+    
+    uint32_t song_count = 0;
+    reader.readU32(song_count);
+    songs.reserve(song_count);
+    song_length_ranges.reserve(song_count);
+    song_index.reserve(song_count);
+    md5_index.reserve(song_count);
+    for (uint32_t i = 0; i < song_count && reader.ok(); i++) {
+        std::string_view path;
+        uint32_t length_count = 0;
+        SongEntry entry;
+        reader.readString(path);
+        reader.readBytes(entry.md5.data(), entry.md5.size());
+        reader.readU32(length_count);
+        
+        Range lengths{static_cast<uint32_t>(song_lengths.size()), length_count};
+        for (uint32_t j = 0; j < length_count && reader.ok(); j++) {
+            uint32_t length = 0;
+            reader.readU32(length);
+            song_lengths.push_back(static_cast<int>(length));
+        }
+        
+        entry.path = arena.store(path);
+        entry.filename = entry.path.substr(entry.path.find_last_of('/') + 1);
+        addSong(entry, lengths);
+    }
+    
+    if (!reader.ok()) {
+        clear();
+        return false;
+    }
+    
+    finalize();
+    return true;
+}
+
+void Catalog::saveIndexCache(const std::string& cache_path, const std::vector<std::string>& source_paths) const {
+    IndexCacheWriter writer("catalog", source_paths);
+    
+    // Paths come from the index since entries do not carry their own STIL path
+    std::vector<std::string_view> stil_paths(stil_entries.size());
+    for (const auto& [path, id] : stil_index) {
+        stil_paths[id] = path;
+    }
+    
+    writer.writeU32(static_cast<uint32_t>(stil_entries.size()));
+    for (size_t i = 0; i < stil_entries.size(); i++) {
+        const StilEntry& entry = stil_entries[i];
+        writer.writeString(stil_paths[i]);
+        writer.writeString(entry.title);
+        writer.writeString(entry.artist);
+        writer.writeString(entry.comment);
+        writer.writeString(entry.copyright);
+        writer.writeU32(static_cast<uint32_t>(entry.subtune_info.size()));
+        for (std::string_view subtune : entry.subtune_info) {
+            writer.writeString(subtune);
+        }
+    }
+    
+    writer.writeU32(static_cast<uint32_t>(songs.size()));
+    for (const auto& entry : songs) {
+        writer.writeString(entry.path);
+        writer.writeBytes(entry.md5.data(), entry.md5.size());
+        writer.writeU32(static_cast<uint32_t>(entry.lengths.size()));
+        for (int length : entry.lengths) {
+            writer.writeU32(static_cast<uint32_t>(length));
+        }
+    }
+    
+    writer.commit(cache_path);
+}
+
+std::string Catalog::toHvscPath(const std::string& sid_file_path) const {
+    try {
+        // Get absolute path of the SID file
+        std::filesystem::path abs_path;
+        if (std::filesystem::path(sid_file_path).is_absolute()) {
+            abs_path = std::filesystem::canonical(sid_file_path);
+        } else {
+            abs_path = std::filesystem::canonical(std::filesystem::current_path() / sid_file_path);
+        }
+        
+        // Get relative path from HVSC root (already canonical)
+        std::filesystem::path rel_path = std::filesystem::relative(abs_path, hvsc_root_path);
+        
+        // Convert to HVSC format (forward slashes, leading slash)
+        std::string hvsc_path = "/" + rel_path.string();
+        
+        // Replace backslashes with forward slashes (Windows compatibility)
+        std::replace(hvsc_path.begin(), hvsc_path.end(), '\\', '/');
+        
+        return hvsc_path;
+    } catch (const std::filesystem::filesystem_error& e) {
+        return "";
+    }
+}
\ No newline at end of file
@@ -5,7 +5,7 @@
 #include <algorithm>
 #include <cstdlib>
 
-Config::Config() : current_theme_name("default") {
+Config::Config() : audio_buffer_ms(200), current_theme_name("default") {
     initializeDirectories();
     
     // Set default HVSC root to ~/Music/C64Music
@@ -35,6 +35,20 @@ void Config::initializeDirectories() {
     themes_dir = config_dir + "/themes";
     config_file = config_dir + "/config";
     
+    // Database indexes are disposable, so they go under the XDG cache dir
+    const char* xdg_cache_home = std::getenv("XDG_CACHE_HOME");
+    
+    if (xdg_cache_home && *xdg_cache_home) {
+        cache_dir = std::string(xdg_cache_home) + "/nancyplayer";
+    } else {
+        const char* home = std::getenv("HOME");
+        if (home && *home) {
+            cache_dir = std::string(home) + "/.cache/nancyplayer";
+        } else {
+            cache_dir = "./cache";  // Fallback
+        }
+    }
+    
     // Create directories if they don't exist
     try {
         std::filesystem::create_directories(config_dir);
@@ -42,6 +56,12 @@ void Config::initializeDirectories() {
     } catch (const std::filesystem::filesystem_error& e) {
         std::cerr << "Warning: Could not create config directories: " << e.what() << std::endl;
     }
+    
+    try {
+        std::filesystem::create_directories(cache_dir);
+    } catch (const std::filesystem::filesystem_error& e) {
+        std::cerr << "Warning: Could not create cache directory: " << e.what() << std::endl;
+    }
 }
 
 bool Config::loadConfig() {
@@ -85,6 +105,12 @@ bool Config::loadConfig() {
                 theme_name = value;
             } else if (key == "hvsc_root") {
                 hvsc_root = value;
+            } else if (key == "audio_buffer_ms") {
+                try {
+                    audio_buffer_ms = std::max(0, std::stoi(value));
+                } catch (const std::exception&) {
+                    // Keep the default for malformed values
+                }
             }
         }
     }
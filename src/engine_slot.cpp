@@ -0,0 +1,60 @@
+#include "engine_slot.h"
+#include <iostream>
+#include <algorithm>
+
+std::unique_ptr<EngineSlot> EngineSlot::create() {
+    auto slot = std::make_unique<EngineSlot>();
+    slot->engine = std::make_unique<sidplayfp>();
+    
+    // Create ReSIDfp builder for SID emulation
+    slot->builder = std::make_unique<ReSIDfpBuilder>("ReSIDfp");
+    
+    // Create SID chips (usually 1 is used, but some tunes use more)
+    slot->builder->create(slot->engine->info().maxsids());
+    if (!slot->builder->getStatus()) {
+        std::cerr << "Failed to create SID chips" << std::endl;
+        return nullptr;
+    }
+    return slot;
+}
+
+bool EngineSlot::configure(int sample_rate) {
+    SidConfig config;
+    config.frequency = sample_rate;
+    config.playback = SidConfig::MONO;
+    config.samplingMethod = SidConfig::INTERPOLATE;
+    config.fastSampling = false;
+    config.sidEmulation = builder.get(); // Use ReSIDfp emulation
+    
+    const SidConfig& current = engine->config();
+    if (current.frequency == config.frequency && current.playback == config.playback &&
+        current.samplingMethod == config.samplingMethod && current.fastSampling == config.fastSampling &&
+        current.sidEmulation == config.sidEmulation) {
+        return true;
+    }
+    
+    if (!engine->config(config)) {
+        std::cerr << "Failed to configure SID engine" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool EngineSlot::loadTune(std::unique_ptr<SidTune>& new_tune, int new_track) {
+    const SidTuneInfo* info = new_tune->getInfo();
+    if (!info) {
+        return false;
+    }
+    
+    int selected = new_track > 0 ? std::min<int>(new_track, info->songs()) : info->startSong();
+    new_tune->selectSong(selected);
+    if (!engine->load(new_tune.get())) {
+        std::cerr << "Failed to load SID tune into engine" << std::endl;
+        return false;
+    }
+    
+    // The previous tune, if any, is only released once the engine let go of it
+    tune = std::move(new_tune);
+    track = selected;
+    return true;
+}
@@ -0,0 +1,118 @@
+#include "event_loop.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cerrno>
+
+EventNotifier::EventNotifier() {
+    fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+EventNotifier::~EventNotifier() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+void EventNotifier::notify() {
+    uint64_t one = 1;
+    if (fd >= 0) {
+        // Only fails with EAGAIN once the counter is saturated, which still wakes the loop
+        ssize_t written = write(fd, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+void EventNotifier::drain() {
+    uint64_t count;
+    if (fd >= 0) {
+        ssize_t bytes = read(fd, &count, sizeof(count));
+        (void)bytes;
+    }
+}
+
+EventLoop::EventLoop() {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+}
+
+EventLoop::~EventLoop() {
+    for (int fd : owned_fds) {
+        close(fd);
+    }
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+    }
+}
+
+bool EventLoop::add(int fd, Handler handler) {
+    if (epoll_fd < 0 || fd < 0) {
+        return false;
+    }
+    
+    auto entry = std::make_unique<Watch>();
+    entry->fd = fd;
+    entry->handler = std::move(handler);
+    
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = entry.get();
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        return false;
+    }
+    watches.push_back(std::move(entry));
+    return true;
+}
+
+bool EventLoop::watch(int fd, Handler handler) {
+    return add(fd, std::move(handler));
+}
+
+bool EventLoop::watch(EventNotifier& notifier, Handler handler) {
+    EventNotifier* source = &notifier;
+    return add(notifier.getFd(), [source, handler = std::move(handler)] {
+        source->drain();
+        if (handler) {
+            handler();
+        }
+    });
+}
+
+bool EventLoop::watchSignal(int signal_number, Handler handler) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, signal_number);
+    if (pthread_sigmask(SIG_BLOCK, &mask, nullptr) != 0) {
+        return false;
+    }
+    
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    owned_fds.push_back(fd);
+    
+    return add(fd, [fd, handler = std::move(handler)] {
+        // Signals of one kind coalesce, so a single handler call covers all of them
+        signalfd_siginfo info;
+        while (read(fd, &info, sizeof(info)) == sizeof(info)) {
+        }
+        if (handler) {
+            handler();
+        }
+    });
+}
+
+int EventLoop::wait(int timeout_ms) {
+    epoll_event events[16];
+    int count = epoll_wait(epoll_fd, events, 16, timeout_ms);
+    if (count < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        static_cast<Watch*>(events[i].data.ptr)->handler();
+    }
+    return count;
+}
\ No newline at end of file
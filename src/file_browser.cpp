@@ -7,6 +7,15 @@ FileBrowser::FileBrowser() : selected_index(0) {
     scanDirectory();
 }
 
+void FileBrowser::setHvscRoot(const std::string& path) {
+    try {
+        hvsc_root = std::filesystem::canonical(path).string();
+    } catch (const std::filesystem::filesystem_error&) {
+        hvsc_root = path;
+    }
+    updateHvscPaths();
+}
+
 void FileBrowser::setDirectory(const std::string& path) {
     try {
         std::filesystem::path new_path = std::filesystem::canonical(path);
@@ -74,6 +83,13 @@ std::string FileBrowser::getSelectedFile() const {
     return "";
 }
 
+const FileEntry* FileBrowser::getSelectedEntry() const {
+    if (selected_index >= 0 && static_cast<size_t>(selected_index) < entries.size()) {
+        return &entries[selected_index];
+    }
+    return nullptr;
+}
+
 void FileBrowser::scanDirectory() {
     entries.clear();
     
@@ -103,6 +119,31 @@ void FileBrowser::scanDirectory() {
         
     } catch (const std::filesystem::filesystem_error&) {
     }
+    
+    updateHvscPaths();
+}
+
+void FileBrowser::updateHvscPaths() {
+    // current_path is canonical, so the catalog key of every entry is a plain
+    // string suffix of the root and no path needs resolving per entry
+    current_hvsc_path.clear();
+    if (!hvsc_root.empty() && current_path.compare(0, hvsc_root.size(), hvsc_root) == 0) {
+        if (current_path.size() == hvsc_root.size()) {
+            current_hvsc_path = "/";
+        } else if (current_path[hvsc_root.size()] == '/') {
+            current_hvsc_path = current_path.substr(hvsc_root.size());
+        }
+    }
+    
+    for (auto& entry : entries) {
+        if (current_hvsc_path.empty()) {
+            entry.hvsc_path.clear();
+        } else if (current_hvsc_path == "/") {
+            entry.hvsc_path = "/" + entry.name;
+        } else {
+            entry.hvsc_path = current_hvsc_path + "/" + entry.name;
+        }
+    }
 }
 
 bool FileBrowser::isSidFile(const std::string& filename) {
@@ -0,0 +1,158 @@
+#include "fuzzy_match.h"
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace fuzzy {
+
+// Letters get a bit each; digits share the six remaining bits, which only
+// makes the prefilter more permissive, never wrong
+static inline uint32_t charBit(unsigned char c) {
+    if (c >= 'a' && c <= 'z') return 1u << (c - 'a');
+    if (c >= '0' && c <= '9') return 1u << (26 + (c - '0') % 6);
+    return 0;
+}
+
+static inline bool isWordChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9');
+}
+
+uint32_t charMask(std::string_view text) {
+    uint32_t mask = 0;
+    for (char c : text) {
+        mask |= charBit(static_cast<unsigned char>(c));
+    }
+    return mask;
+}
+
+void filterByMask(const uint32_t* masks, const uint32_t* ids, size_t count, uint32_t pattern_mask, std::vector<uint32_t>& out) {
+    size_t i = 0;
+    
+#if defined(__SSE2__)
+    // Test four masks per iteration for (mask & pattern) == pattern
+    const __m128i pattern = _mm_set1_epi32(static_cast<int>(pattern_mask));
+    for (; i + 4 <= count; i += 4) {
+        // Full scans pass consecutive ids, whose masks load in one go; refined
+        // candidate lists are sparse and need the lanes gathered one by one
+        __m128i block;
+        if (ids[i + 1] == ids[i] + 1 && ids[i + 2] == ids[i] + 2 && ids[i + 3] == ids[i] + 3) {
+            block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks + ids[i]));
+        } else {
+            block = _mm_set_epi32(static_cast<int>(masks[ids[i + 3]]), static_cast<int>(masks[ids[i + 2]]),
+                                  static_cast<int>(masks[ids[i + 1]]), static_cast<int>(masks[ids[i]]));
+        }
+        __m128i hit = _mm_cmpeq_epi32(_mm_and_si128(block, pattern), pattern);
+        int bits = _mm_movemask_ps(_mm_castsi128_ps(hit));
+        if (bits == 0) {
+            continue;
+        }
+        for (int lane = 0; lane < 4; lane++) {
+            if (bits & (1 << lane)) {
+                out.push_back(ids[i + lane]);
+            }
+        }
+    }
+#endif
+    
+    for (; i < count; i++) {
+        if ((masks[ids[i]] & pattern_mask) == pattern_mask) {
+            out.push_back(ids[i]);
+        }
+    }
+}
+
+// Leftmost match of the whole pattern; returns one past its last character,
+// or 0 if pattern is not a subsequence. With SSE2 every 16-byte block is
+// loaded once and tested against as many pattern characters as it holds.
+static size_t matchForward(std::string_view text, std::string_view pattern) {
+    size_t pos = 0;
+    size_t p = 0;
+    
+#if defined(__SSE2__)
+    for (; pos + 16 <= text.size(); pos += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + pos));
+        unsigned taken = 0; // lanes before this one are already used
+        while (taken < 16) {
+            unsigned hits = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(pattern[p]))));
+            hits &= 0xffffu << taken;
+            if (!hits) {
+                break;
+            }
+            taken = static_cast<unsigned>(__builtin_ctz(hits)) + 1;
+            if (++p == pattern.size()) {
+                return pos + taken;
+            }
+        }
+    }
+#endif
+    
+    for (; pos < text.size(); pos++) {
+        if (text[pos] == pattern[p] && ++p == pattern.size()) {
+            return pos + 1;
+        }
+    }
+    return 0;
+}
+
+// Walks back from a match ending at end and scores the rightmost alignment
+// inside the shortest window ending there: 16 per character, 8 more at word
+// starts, 4 per preceding character in a consecutive run, and gaps cost 3
+// to open plus 1 per further character. Only matched positions are visited;
+// the text between them is skipped 16 bytes at a time.
+static int scoreBackward(std::string_view text, std::string_view pattern, size_t end) {
+    int total = 0;
+    int run = 1;          // length of the consecutive run the last match belongs to
+    size_t next = end - 1; // position of the match to the right, pattern's last char is there
+    auto scoreMatch = [&](size_t pos) {
+        total += 16;
+        if (pos == 0 || !isWordChar(text[pos - 1])) {
+            total += 8; // start of a word
+        }
+    };
+    scoreMatch(next);
+    
+    for (size_t p = pattern.size() - 1; p-- > 0;) {
+        size_t pos = next;
+        bool found = false;
+#if defined(__SSE2__)
+        // Blocks ending at pos, highest matching lane first
+        while (pos >= 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + pos - 16));
+            unsigned hits = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(pattern[p]))));
+            if (hits) {
+                pos = pos - 16 + (31 - static_cast<unsigned>(__builtin_clz(hits)));
+                found = true;
+                break;
+            }
+            pos -= 16;
+        }
+#endif
+        while (!found && pos-- > 0) {
+            found = text[pos] == pattern[p];
+        }
+        
+        scoreMatch(pos);
+        if (pos + 1 == next) {
+            run++;
+        } else {
+            total += 2 * run * (run - 1); // 4 * (0 + 1 + ... + run - 1)
+            total -= static_cast<int>(next - pos - 1) + 2;
+            run = 1;
+        }
+        next = pos;
+    }
+    total += 2 * run * (run - 1);
+    
+    return std::max(total, 1);
+}
+
+int score(std::string_view text, std::string_view pattern) {
+    if (pattern.empty()) {
+        return 0;
+    }
+    size_t end = matchForward(text, pattern);
+    return end ? scoreBackward(text, pattern, end) : -1;
+}
+
+}
\ No newline at end of file
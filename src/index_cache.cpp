@@ -0,0 +1,163 @@
+#include "index_cache.h"
+#include <cstring>
+#include <cstdio>
+#include <sys/stat.h>
+
+// Bump whenever the layout of any index changes so old caches get rebuilt
+static const uint32_t INDEX_CACHE_VERSION = 4;
+static const char INDEX_CACHE_MAGIC[8] = {'N', 'A', 'N', 'C', 'Y', 'I', 'D', 'X'};
+
+bool SourceStamp::read(const std::string& path, SourceStamp& stamp) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    stamp.size = static_cast<uint64_t>(st.st_size);
+    stamp.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+IndexCacheWriter::IndexCacheWriter(const std::string& kind, const std::vector<std::string>& source_paths) : stamps_valid(true) {
+    buffer.append(INDEX_CACHE_MAGIC, sizeof(INDEX_CACHE_MAGIC));
+    writeU32(INDEX_CACHE_VERSION);
+    writeString(kind);
+    writeU32(static_cast<uint32_t>(source_paths.size()));
+    
+    for (const auto& path : source_paths) {
+        SourceStamp stamp;
+        if (!SourceStamp::read(path, stamp)) {
+            stamps_valid = false;
+        }
+        writeString(path);
+        buffer.append(reinterpret_cast<const char*>(&stamp.size), sizeof(stamp.size));
+        buffer.append(reinterpret_cast<const char*>(&stamp.mtime_ns), sizeof(stamp.mtime_ns));
+    }
+}
+
+void IndexCacheWriter::writeU32(uint32_t value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void IndexCacheWriter::writeString(std::string_view value) {
+    writeU32(static_cast<uint32_t>(value.size()));
+    buffer.append(value.data(), value.size());
+}
+
+void IndexCacheWriter::writeBytes(const void* data, size_t length) {
+    buffer.append(static_cast<const char*>(data), length);
+}
+
+bool IndexCacheWriter::commit(const std::string& cache_path) {
+    if (!stamps_valid || cache_path.empty()) {
+        return false;
+    }
+    
+    // Write to a temporary file and rename so readers never see a partial index
+    std::string tmp_path = cache_path + ".tmp";
+    FILE* file = std::fopen(tmp_path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    
+    bool written = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    written = (std::fclose(file) == 0) && written;
+    
+    if (!written || std::rename(tmp_path.c_str(), cache_path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+IndexCacheReader::IndexCacheReader() : data(nullptr), size(0), pos(0), failed(true) {
+}
+
+IndexCacheReader::~IndexCacheReader() {
+    close();
+}
+
+bool IndexCacheReader::open(const std::string& cache_path, const std::string& kind, const std::vector<std::string>& source_paths) {
+    close();
+    
+    if (!file.open(cache_path) || file.getSize() < sizeof(INDEX_CACHE_MAGIC)) {
+        file.close();
+        return false;
+    }
+    
+    data = file.getData();
+    size = file.getSize();
+    pos = sizeof(INDEX_CACHE_MAGIC);
+    failed = std::memcmp(data, INDEX_CACHE_MAGIC, sizeof(INDEX_CACHE_MAGIC)) != 0;
+    
+    uint32_t version = 0;
+    std::string_view cached_kind;
+    uint32_t source_count = 0;
+    if (!readU32(version) || version != INDEX_CACHE_VERSION ||
+        !readString(cached_kind) || cached_kind != kind ||
+        !readU32(source_count) || source_count != source_paths.size()) {
+        close();
+        return false;
+    }
+    
+    // Another source file, or any change to one, invalidates the whole index
+    for (const auto& path : source_paths) {
+        std::string_view cached_path;
+        SourceStamp cached;
+        SourceStamp current;
+        if (!readString(cached_path) || cached_path != path ||
+            pos + sizeof(cached.size) + sizeof(cached.mtime_ns) > size) {
+            close();
+            return false;
+        }
+        std::memcpy(&cached.size, data + pos, sizeof(cached.size));
+        pos += sizeof(cached.size);
+        std::memcpy(&cached.mtime_ns, data + pos, sizeof(cached.mtime_ns));
+        pos += sizeof(cached.mtime_ns);
+        
+        if (!SourceStamp::read(path, current) || !(current == cached)) {
+            close();
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+void IndexCacheReader::close() {
+    file.close();
+    data = nullptr;
+    size = 0;
+    pos = 0;
+    failed = true;
+}
+
+bool IndexCacheReader::readU32(uint32_t& value) {
+    if (failed || pos + sizeof(value) > size) {
+        failed = true;
+        return false;
+    }
+    std::memcpy(&value, data + pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+}
+
+bool IndexCacheReader::readString(std::string_view& value) {
+    uint32_t length = 0;
+    if (!readU32(length) || pos + length > size) {
+        failed = true;
+        return false;
+    }
+    value = std::string_view(data + pos, length);
+    pos += length;
+    return true;
+}
+
+bool IndexCacheReader::readBytes(void* out, size_t length) {
+    if (failed || pos + length > size) {
+        failed = true;
+        return false;
+    }
+    std::memcpy(out, data + pos, length);
+    pos += length;
+    return true;
+}
\ No newline at end of file
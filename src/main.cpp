@@ -1,9 +1,18 @@
 #include "tui.h"
+#include "render_command.h"
 #include <iostream>
 #include <stdexcept>
+#include <cstring>
 
-int main() {
+int main(int argc, char** argv) {
     try {
+        if (argc > 1 && std::strcmp(argv[1], "render") == 0) {
+            return runRenderCommand(argc - 2, argv + 2);
+        }
+        if (argc > 1 && std::strcmp(argv[1], "batch") == 0) {
+            return runBatchCommand(argc - 2, argv + 2);
+        }
+        
         TUI tui;
         tui.run();
     } catch (const std::exception& e) {
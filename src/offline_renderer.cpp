@@ -0,0 +1,127 @@
+#include "offline_renderer.h"
+#include "engine_slot.h"
+#include "mapped_file.h"
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+
+static const size_t RENDER_CHUNK_SAMPLES = 16384; // large chunks, nothing waits on them
+static const size_t WAV_HEADER_SIZE = 44;
+
+static void putLe16(uint8_t* out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+static void putLe32(uint8_t* out, uint32_t value) {
+    putLe16(out, static_cast<uint16_t>(value));
+    putLe16(out + 2, static_cast<uint16_t>(value >> 16));
+}
+
+static bool writeWavHeader(FILE* file, int sample_rate, uint32_t data_bytes) {
+    uint8_t header[WAV_HEADER_SIZE];
+    std::copy_n("RIFF", 4, header);
+    putLe32(header + 4, static_cast<uint32_t>(WAV_HEADER_SIZE - 8 + data_bytes));
+    std::copy_n("WAVEfmt ", 8, header + 8);
+    putLe32(header + 16, 16);                                          // fmt chunk size
+    putLe16(header + 20, 1);                                           // PCM
+    putLe16(header + 22, 1);                                           // mono
+    putLe32(header + 24, static_cast<uint32_t>(sample_rate));
+    putLe32(header + 28, static_cast<uint32_t>(sample_rate) * sizeof(short)); // byte rate
+    putLe16(header + 32, sizeof(short));                               // block align
+    putLe16(header + 34, 16);                                          // bits per sample
+    std::copy_n("data", 4, header + 36);
+    putLe32(header + 40, data_bytes);
+    return std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+}
+
+static int64_t lengthForTrack(const RenderJob& job, int track) {
+    if (job.length_ms > 0) {
+        return job.length_ms;
+    }
+    if (track >= 1 && track <= static_cast<int>(job.song_lengths.size())) {
+        return static_cast<int64_t>(job.song_lengths[track - 1]) * 1000;
+    }
+    return 0;
+}
+
+bool renderToFile(const RenderJob& job, RenderStats& stats, std::string& error) {
+    std::unique_ptr<EngineSlot> slot = EngineSlot::create();
+    if (!slot) {
+        stats = RenderStats();
+        error = "cannot set up the emulation";
+        return false;
+    }
+    return renderToFile(*slot, job, stats, error);
+}
+
+bool renderToFile(EngineSlot& slot, const RenderJob& job, RenderStats& stats, std::string& error) {
+    stats = RenderStats();
+    
+    MappedFile input;
+    if (!input.open(job.input_path)) {
+        error = "cannot read " + job.input_path;
+        return false;
+    }
+    auto tune = std::make_unique<SidTune>(reinterpret_cast<const uint_least8_t*>(input.getData()),
+                                          static_cast<uint_least32_t>(input.getSize()));
+    input.close();
+    if (!tune->getStatus()) {
+        error = job.input_path + ": " + tune->statusString();
+        return false;
+    }
+    
+    if (!slot.configure(job.sample_rate) || !slot.loadTune(tune, job.track)) {
+        error = "cannot set up the emulation for " + job.input_path;
+        return false;
+    }
+    stats.track = slot.track;
+    
+    int64_t length_ms = lengthForTrack(job, slot.track);
+    if (length_ms <= 0) {
+        error = job.input_path + " track " + std::to_string(slot.track) + ": length unknown";
+        return false;
+    }
+    uint64_t total_samples = static_cast<uint64_t>(length_ms) * job.sample_rate / 1000;
+    uint64_t total_bytes = total_samples * sizeof(short);
+    if (job.format == PcmFormat::Wav && total_bytes > UINT32_MAX - WAV_HEADER_SIZE) {
+        error = "too long for a WAV file, render raw instead";
+        return false;
+    }
+    
+    FILE* output = std::fopen(job.output_path.c_str(), "wb");
+    if (!output) {
+        error = "cannot write " + job.output_path;
+        return false;
+    }
+    
+    auto started = std::chrono::steady_clock::now();
+    
+    bool written = job.format != PcmFormat::Wav || writeWavHeader(output, job.sample_rate, static_cast<uint32_t>(total_bytes));
+    std::vector<short> chunk(RENDER_CHUNK_SAMPLES);
+    while (written && stats.samples < total_samples) {
+        size_t count = static_cast<size_t>(std::min<uint64_t>(RENDER_CHUNK_SAMPLES, total_samples - stats.samples));
+        int samples = static_cast<int>(slot.engine->play(chunk.data(), static_cast<uint_least32_t>(count)));
+        if (samples <= 0) {
+            break; // the tune stopped, the header is corrected below
+        }
+        written = std::fwrite(chunk.data(), sizeof(short), samples, output) == static_cast<size_t>(samples);
+        stats.samples += samples;
+    }
+    
+    // Fix up the header if the emulation ended early
+    if (written && job.format == PcmFormat::Wav && stats.samples != total_samples) {
+        written = std::fseek(output, 0, SEEK_SET) == 0 &&
+                  writeWavHeader(output, job.sample_rate, static_cast<uint32_t>(stats.samples * sizeof(short)));
+    }
+    written = (std::fclose(output) == 0) && written;
+    
+    stats.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    
+    if (!written) {
+        error = "error writing " + job.output_path;
+        std::remove(job.output_path.c_str());
+        return false;
+    }
+    return true;
+}
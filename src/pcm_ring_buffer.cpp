@@ -0,0 +1,94 @@
+#include "pcm_ring_buffer.h"
+#include <algorithm>
+#include <cstring>
+
+static size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+PcmRingBuffer::PcmRingBuffer(size_t min_capacity)
+    : buffer(roundUpToPowerOfTwo(std::max<size_t>(min_capacity, 2))), write_pos(0), discard_pos(0), discards(0), read_pos(0), changes(0) {
+    mask = buffer.size() - 1;
+}
+
+size_t PcmRingBuffer::write(const short* samples, size_t count) {
+    size_t write_index = write_pos.load(std::memory_order_relaxed);
+    size_t read_index = read_pos.load(std::memory_order_acquire);
+    count = std::min(count, capacity() - (write_index - read_index));
+    if (count == 0) {
+        return 0;
+    }
+    
+    // Copy in at most two pieces around the end of the buffer
+    size_t offset = write_index & mask;
+    size_t first = std::min(count, capacity() - offset);
+    std::memcpy(buffer.data() + offset, samples, first * sizeof(short));
+    std::memcpy(buffer.data(), samples + first, (count - first) * sizeof(short));
+    
+    write_pos.store(write_index + count, std::memory_order_release);
+    wake();
+    return count;
+}
+
+size_t PcmRingBuffer::read(short* samples, size_t count) {
+    size_t read_index = read_pos.load(std::memory_order_relaxed);
+    size_t write_index = write_pos.load(std::memory_order_acquire);
+    count = std::min(count, write_index - read_index);
+    if (count == 0) {
+        return 0;
+    }
+    
+    size_t offset = read_index & mask;
+    size_t first = std::min(count, capacity() - offset);
+    std::memcpy(samples, buffer.data() + offset, first * sizeof(short));
+    std::memcpy(samples + first, buffer.data(), (count - first) * sizeof(short));
+    
+    read_pos.store(read_index + count, std::memory_order_release);
+    wake();
+    return count;
+}
+
+void PcmRingBuffer::discard() {
+    discard_pos.store(write_pos.load(std::memory_order_relaxed), std::memory_order_release);
+    discards.fetch_add(1, std::memory_order_release);
+    wake();
+}
+
+bool PcmRingBuffer::skipDiscarded() {
+    size_t read_index = read_pos.load(std::memory_order_relaxed);
+    size_t discard_index = discard_pos.load(std::memory_order_acquire);
+    if (read_index >= discard_index) {
+        return false;
+    }
+    read_pos.store(discard_index, std::memory_order_release);
+    wake();
+    return true;
+}
+
+size_t PcmRingBuffer::getReadable() const {
+    size_t read_index = std::max(read_pos.load(std::memory_order_acquire), discard_pos.load(std::memory_order_acquire));
+    size_t write_index = write_pos.load(std::memory_order_acquire);
+    // Seen from a third thread read_pos may lag behind write_pos by more than the capacity
+    return std::min(write_index - std::min(read_index, write_index), capacity());
+}
+
+size_t PcmRingBuffer::getWritable() const {
+    size_t read_index = read_pos.load(std::memory_order_acquire);
+    size_t write_index = write_pos.load(std::memory_order_acquire);
+    return capacity() - std::min(write_index - read_index, capacity());
+}
+
+void PcmRingBuffer::clear() {
+    write_pos.store(0, std::memory_order_relaxed);
+    discard_pos.store(0, std::memory_order_relaxed);
+    read_pos.store(0, std::memory_order_relaxed);
+}
+
+void PcmRingBuffer::wake() {
+    changes.fetch_add(1, std::memory_order_release);
+    changes.notify_all();
+}
\ No newline at end of file
@@ -1,172 +1,605 @@
 #include "player.h"
-#include <fstream>
-#include <iostream>
 #include <vector>
 #include <cstring>
+#include <chrono>
+#include <algorithm>
 #include <pulse/simple.h>
 #include <pulse/error.h>
 #include <pulse/def.h>
-#include <sidplayfp/builders/residfp.h>
 
-Player::Player() : current_track(1), track_count(0), playing(false), paused(false), should_stop(false), play_time(0), sid_builder(nullptr) {
-    engine = std::make_unique<sidplayfp>();
+static const int SAMPLE_RATE = 44100;
+static const size_t CHUNK_SAMPLES = 1024; // ~23ms, the unit both threads move samples in
+static const int DEFAULT_BUFFER_MS = 200;
+static const size_t MAX_SPARE_SLOTS = 2; // warm engines kept besides the current and queued one
+
+Player::Player() : queued_id(0), loading_id(0), last_request_id(0), failed_track(0), state(std::make_shared<const PlayerState>()), rendering(false), render_position(0), skip_until(0),
+                   high_water_mark(0), output_enabled(false), render_finished(false), should_quit(false), output_start_sample(0), samples_played(0),
+                   output_latency_us(0), underruns(0), has_load_request(false), has_queue_request(false), quit_preparing(false) {
+    setBufferLength(DEFAULT_BUFFER_MS);
 }
 
 Player::~Player() {
-    stop();
-    delete sid_builder;
+    // The preparer posts commands, so it goes first
+    if (prepare_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(request_mutex);
+            quit_preparing = true;
+        }
+        request_ready.notify_one();
+        prepare_thread.join();
+    }
+    if (render_thread.joinable()) {
+        PlayerCommand command;
+        command.type = PlayerCommand::Quit;
+        post(std::move(command));
+        render_thread.join();
+        audio_thread.join();
+    }
 }
 
-bool Player::loadFile(const std::string& filename) {
-    stop();
-    
-    std::ifstream file(filename, std::ios::binary);
-    if (!file) {
-        return false;
+std::unique_ptr<EngineSlot> Player::prepareSlot(const std::string& filename, int track, PlayerState& info) {
+    // Recently played tunes come out of the cache without touching the file
+    collectRetiredSlots();
+    SourceStamp stamp;
+    std::unique_ptr<SidTune> new_tune = tune_cache.take(filename, stamp);
+    if (!new_tune) {
+        return nullptr;
     }
     
-    file.seekg(0, std::ios::end);
-    size_t size = file.tellg();
-    file.seekg(0, std::ios::beg);
-    
-    std::vector<uint8_t> data(size);
-    file.read(reinterpret_cast<char*>(data.data()), size);
-    file.close();
-    
-    tune = std::make_unique<SidTune>(data.data(), size);
-    if (!tune->getStatus()) {
-        return false;
+    const SidTuneInfo* tune_info = new_tune->getInfo();
+    if (!tune_info) {
+        return nullptr;
     }
     
-    const SidTuneInfo* info = tune->getInfo();
-    if (!info) {
-        return false;
+    // The slot is set up here and only handed to the render thread once it
+    // is ready, so the engine that is playing is never touched from here
+    std::unique_ptr<EngineSlot> slot = takeSpareSlot();
+    if (!slot) {
+        slot = EngineSlot::create();
+    }
+    if (!slot || !slot->configure(SAMPLE_RATE) || !slot->loadTune(new_tune, track)) {
+        return nullptr;
     }
     
-    current_file = filename;
-    track_count = info->songs();
-    current_track = info->startSong();
-    
-    title = info->infoString(0) ? info->infoString(0) : "";
-    author = info->infoString(1) ? info->infoString(1) : "";
-    copyright = info->infoString(2) ? info->infoString(2) : "";
-    
-    tune->selectSong(current_track);
+    slot->tune_path = filename;
+    slot->tune_stamp = stamp;
+    slot->length_samples = lookupLengthSamples(filename, slot->track);
+    slot->queue_id = 0;
     
-    // Clean up previous SID builder if it exists
-    delete sid_builder;
+    info.file = filename;
+    info.track_count = tune_info->songs();
+    info.track = slot->track;
     
-    // Reset the engine to clean state
-    engine.reset();
-    engine = std::make_unique<sidplayfp>();
+    info.title = tune_info->infoString(0) ? tune_info->infoString(0) : "";
+    info.author = tune_info->infoString(1) ? tune_info->infoString(1) : "";
+    info.copyright = tune_info->infoString(2) ? tune_info->infoString(2) : "";
     
-    // Create ReSIDfp builder for SID emulation
-    sid_builder = new ReSIDfpBuilder("ReSIDfp");
-    if (!sid_builder) {
-        std::cerr << "Failed to create ReSIDfp builder" << std::endl;
-        return false;
+    return slot;
+}
+
+void Player::collectRetiredSlots() {
+    std::unique_ptr<EngineSlot> slot;
+    while (retired_slots.pop(slot)) {
+        recycleSlot(std::move(slot));
     }
-    
-    // Create SID chips (usually 1, but some tunes use more)
-    sid_builder->create(engine->info().maxsids());
-    if (!sid_builder->getStatus()) {
-        std::cerr << "Failed to create SID chips" << std::endl;
-        delete sid_builder;
-        sid_builder = nullptr;
-        return false;
+}
+
+void Player::recycleSlot(std::unique_ptr<EngineSlot> slot) {
+    // Unload first so the engine keeps no pointer to the cached tune
+    if (slot->tune) {
+        slot->engine->load(nullptr);
+        tune_cache.put(slot->tune_path, slot->tune_stamp, std::move(slot->tune));
+    }
+    if (spare_slots.size() < MAX_SPARE_SLOTS) {
+        spare_slots.push_back(std::move(slot));
+    }
+}
+
+std::unique_ptr<EngineSlot> Player::takeSpareSlot() {
+    if (spare_slots.empty()) {
+        return nullptr;
     }
+    std::unique_ptr<EngineSlot> slot = std::move(spare_slots.back());
+    spare_slots.pop_back();
+    return slot;
+}
+
+void Player::retireSlot(std::unique_ptr<EngineSlot> slot) {
+    // Freed right here if the preparer thread has not collected earlier ones
+    if (slot) {
+        retired_slots.push(std::move(slot));
+    }
+}
+
+uint64_t Player::lookupLengthSamples(const std::string& filename, int track) const {
+    int64_t length_ms = song_length_lookup ? song_length_lookup(filename, track) : 0;
+    return static_cast<uint64_t>(std::max<int64_t>(length_ms, 0)) * SAMPLE_RATE / 1000;
+}
+
+void Player::loadFile(const std::string& filename) {
+    stop();
+    
+    // Parsing the tune and setting up its engine is left to the preparer
+    // thread; until it is done the file is known but its details are not
+    std::lock_guard<std::mutex> lock(state_mutex);
+    failed_file.clear();
+    control_state.file = filename;
+    control_state.title.clear();
+    control_state.author.clear();
+    control_state.copyright.clear();
+    control_state.track = 0;
+    control_state.track_count = 0;
+    control_state.next_file.clear();
+    control_state.next_track = 0;
+    queued_id = 0;
+    loading_id = ++last_request_id;
+    publishState();
     
-    // Configure the SID engine with ReSIDfp emulation
-    SidConfig config;
-    config.frequency = 44100;
-    config.playback = SidConfig::MONO;
-    config.samplingMethod = SidConfig::INTERPOLATE;
-    config.fastSampling = false;
-    config.sidEmulation = sid_builder; // Use ReSIDfp emulation
+    underruns = 0;
     
-    if (!engine->config(config)) {
-        std::cerr << "Failed to configure SID engine" << std::endl;
+    PrepareRequest request;
+    request.filename = filename;
+    request.id = loading_id;
+    requestPreparation(load_request, has_load_request, std::move(request));
+}
+
+bool Player::queueFile(const std::string& filename, int track) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    if (filename == failed_file && track == failed_track) {
         return false;
     }
+    queued_id = ++last_request_id;
+    control_state.next_file = filename;
+    control_state.next_track = track;
+    publishState();
     
-    if (!engine->load(tune.get())) {
-        std::cerr << "Failed to load SID tune into engine" << std::endl;
-        return false;
+    PrepareRequest request;
+    request.filename = filename;
+    request.track = track;
+    request.id = queued_id;
+    requestPreparation(queue_request, has_queue_request, std::move(request));
+    return true;
+}
+
+// Called with state_mutex held, so requests reach the preparer in the
+// order their ids were handed out
+void Player::requestPreparation(PrepareRequest& pending, bool& has_pending, PrepareRequest request) {
+    {
+        std::lock_guard<std::mutex> lock(request_mutex);
+        pending = std::move(request);
+        has_pending = true;
+    }
+    if (!prepare_thread.joinable()) {
+        prepare_thread = std::thread(&Player::prepareThread, this);
+    }
+    request_ready.notify_one();
+}
+
+void Player::prepareThread() {
+    while (true) {
+        PrepareRequest request;
+        bool is_load;
+        {
+            std::unique_lock<std::mutex> lock(request_mutex);
+            request_ready.wait(lock, [this] { return has_load_request || has_queue_request || quit_preparing; });
+            if (quit_preparing) {
+                return;
+            }
+            // A load drops the queue, so it goes first and a queue request
+            // made after it is not overtaken
+            is_load = has_load_request;
+            request = std::move(is_load ? load_request : queue_request);
+            (is_load ? has_load_request : has_queue_request) = false;
+        }
+        
+        // Skip requests a newer load, queue or track change already replaced
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            if (request.id != (is_load ? loading_id : queued_id)) {
+                continue;
+            }
+        }
+        
+        PlayerState info;
+        std::unique_ptr<EngineSlot> slot = prepareSlot(request.filename, request.track, info);
+        
+        // Posted under state_mutex like every other command, so the render
+        // thread sees a single producer
+        std::unique_lock<std::mutex> lock(state_mutex);
+        if (request.id != (is_load ? loading_id : queued_id)) {
+            lock.unlock();
+            if (slot) {
+                recycleSlot(std::move(slot));
+            }
+            continue;
+        }
+        
+        if (is_load) {
+            finishLoad(std::move(slot), info);
+            lock.unlock();
+            notifyStateChange();
+        } else if (!slot) {
+            // Remembered so the UI does not ask for the same broken tune again
+            failed_file = request.filename;
+            failed_track = request.track;
+            control_state.next_file.clear();
+            control_state.next_track = 0;
+            queued_id = 0;
+            publishState();
+            lock.unlock();
+            notifyStateChange();
+        } else {
+            queued_state = std::move(info);
+            slot->queue_id = request.id;
+            
+            PlayerCommand command;
+            command.type = PlayerCommand::Queue;
+            command.slot = std::move(slot);
+            post(std::move(command));
+        }
+    }
+}
+
+// Called with state_mutex held. Whatever play() or pause() asked for while
+// the tune was prepared is applied along with it.
+void Player::finishLoad(std::unique_ptr<EngineSlot> slot, PlayerState& info) {
+    loading_id = 0;
+    if (!slot) {
+        control_state.file.clear();
+        control_state.playing = false;
+        control_state.paused = false;
+        publishState();
+        return;
     }
     
+    control_state.title = std::move(info.title);
+    control_state.author = std::move(info.author);
+    control_state.copyright = std::move(info.copyright);
+    control_state.track = info.track;
+    control_state.track_count = info.track_count;
+    publishState();
     
-    play_time = 0;
+    PlayerCommand command;
+    command.type = PlayerCommand::Load;
+    command.slot = std::move(slot);
+    post(std::move(command));
     
-    return true;
+    if (control_state.playing && !control_state.paused) {
+        PlayerCommand play_command;
+        play_command.type = PlayerCommand::Play;
+        post(std::move(play_command));
+    }
+}
+
+void Player::setBufferLength(int milliseconds) {
+    if (render_thread.joinable()) {
+        return;
+    }
+    
+    // At least two chunks so the renderer can work while one is being played
+    size_t samples = static_cast<size_t>(std::max(milliseconds, 0)) * SAMPLE_RATE / 1000;
+    high_water_mark = std::max(samples, 2 * CHUNK_SAMPLES);
+    pcm_buffer = std::make_unique<PcmRingBuffer>(high_water_mark + CHUNK_SAMPLES);
+}
+
+int64_t Player::getPlayTimeMs() const {
+    int64_t written_ms = static_cast<int64_t>(samples_played * 1000 / SAMPLE_RATE);
+    return std::max<int64_t>(0, written_ms - output_latency_us / 1000);
+}
+
+int Player::getBufferLength() const {
+    return static_cast<int>(high_water_mark * 1000 / SAMPLE_RATE);
 }
 
 void Player::play() {
-    if (tune && !playing) {
-        should_stop = false;
-        playing = true;
-        paused = false;
+    std::lock_guard<std::mutex> lock(state_mutex);
+    if (!control_state.file.empty() && (!control_state.playing || control_state.paused)) {
+        control_state.playing = true;
+        control_state.paused = false;
+        publishState();
         
-        if (audio_thread.joinable()) {
-            audio_thread.join();
-        }
-        if (timer_thread.joinable()) {
-            timer_thread.join();
+        // A tune still being prepared starts playing once it is loaded
+        if (loading_id == 0) {
+            PlayerCommand command;
+            command.type = PlayerCommand::Play;
+            post(std::move(command));
         }
-        
-        audio_thread = std::thread(&Player::audioThread, this);
-        timer_thread = std::thread(&Player::updatePlayTime, this);
-    } else if (playing && paused) {
-        paused = false;
     }
 }
 
 void Player::pause() {
-    if (playing && !paused) {
-        paused = true;
+    std::lock_guard<std::mutex> lock(state_mutex);
+    if (control_state.playing && !control_state.paused) {
+        control_state.paused = true;
+        publishState();
+        
+        if (loading_id == 0) {
+            PlayerCommand command;
+            command.type = PlayerCommand::Pause;
+            post(std::move(command));
+        }
     }
 }
 
 void Player::stop() {
-    if (playing) {
-        should_stop = true;
+    std::lock_guard<std::mutex> lock(state_mutex);
+    if (control_state.playing) {
+        control_state.playing = false;
+        control_state.paused = false;
+        control_state.next_file.clear();
+        control_state.next_track = 0;
+        queued_id = 0;
+        publishState();
         
-        if (audio_thread.joinable()) {
-            audio_thread.join();
+        PlayerCommand command;
+        command.type = PlayerCommand::Stop;
+        post(std::move(command));
+    }
+}
+
+void Player::nextTrack() {
+    selectTrack(1);
+}
+
+void Player::prevTrack() {
+    selectTrack(-1);
+}
+
+void Player::selectTrack(int delta) {
+    while (true) {
+        // The lookup may touch the filesystem, so it runs before state_mutex
+        // is taken and holds up the threads waiting for it
+        std::shared_ptr<const PlayerState> shown = getState();
+        int track = shown->track + delta;
+        if (shown->file.empty() || track < 1 || track > shown->track_count) {
+            return;
         }
-        if (timer_thread.joinable()) {
-            timer_thread.join();
+        int64_t length_ms = song_length_lookup ? song_length_lookup(shown->file, track) : 0;
+        
+        std::lock_guard<std::mutex> lock(state_mutex);
+        if (control_state.version != shown->version) {
+            continue; // the queued tune started or a load finished meanwhile, look again
         }
+        control_state.track = track;
+        control_state.next_file.clear();
+        control_state.next_track = 0;
+        queued_id = 0;
+        publishState();
         
-        playing = false;
-        paused = false;
-        play_time = 0;
+        PlayerCommand command;
+        command.type = PlayerCommand::SelectTrack;
+        command.track = track;
+        command.length_ms = length_ms;
+        post(std::move(command));
+        return;
     }
 }
 
-void Player::nextTrack() {
-    if (tune && current_track < track_count) {
-        current_track++;
-        tune->selectSong(current_track);
-        engine->load(tune.get());
-        play_time = 0;
+void Player::seek(int64_t position_ms) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    if (control_state.playing && loading_id == 0) {
+        PlayerCommand command;
+        command.type = PlayerCommand::Seek;
+        command.position_ms = std::max<int64_t>(position_ms, 0);
+        post(std::move(command));
     }
 }
 
-void Player::prevTrack() {
-    if (tune && current_track > 1) {
-        current_track--;
-        tune->selectSong(current_track);
-        engine->load(tune.get());
-        play_time = 0;
+void Player::publishState() {
+    control_state.version++;
+    state.store(std::make_shared<const PlayerState>(control_state), std::memory_order_release);
+}
+
+void Player::post(PlayerCommand command) {
+    startThreads();
+    
+    // The render thread takes commands between chunks, so the queue only
+    // fills up when commands arrive faster than a chunk is emulated
+    while (!commands.push(std::move(command))) {
+        std::this_thread::yield();
+    }
+    pcm_buffer->wake();
+}
+
+void Player::startThreads() {
+    if (!render_thread.joinable()) {
+        render_thread = std::thread(&Player::renderThread, this);
+        audio_thread = std::thread(&Player::audioThread, this);
+    }
+}
+
+void Player::renderThread() {
+    short chunk[CHUNK_SAMPLES];
+    
+    while (!should_quit) {
+        // Commands and the audio thread reading from the buffer change the
+        // token, so taking it first means neither is missed while sleeping
+        uint32_t token = pcm_buffer->getChangeToken();
+        
+        PlayerCommand command;
+        if (commands.pop(command)) {
+            applyCommand(command);
+            continue;
+        }
+        
+        bool active = current && !render_finished;
+        if (active && render_position < skip_until) {
+            // Seeking forward: emulate up to the target without output, one
+            // chunk at a time so commands are still taken in between
+            size_t count = static_cast<size_t>(std::min<uint64_t>(CHUNK_SAMPLES, skip_until - render_position));
+            int samples = current->engine->play(chunk, count);
+            if (samples <= 0) {
+                render_finished = true;
+                pcm_buffer->wake();
+                continue;
+            }
+            render_position += samples;
+            continue;
+        }
+        
+        // Sleep while stopped or while the buffer is at the high-water mark
+        if (!active || !rendering || pcm_buffer->getReadable() + CHUNK_SAMPLES > high_water_mark ||
+            pcm_buffer->getWritable() < CHUNK_SAMPLES) {
+            pcm_buffer->waitForChange(token);
+            continue;
+        }
+        
+        // With a tune queued, end exactly at the track length so the queued
+        // tune's first sample directly follows the last one of this track
+        size_t count = CHUNK_SAMPLES;
+        if (next && current->length_samples > 0) {
+            if (render_position >= current->length_samples) {
+                startQueuedTrack();
+                continue;
+            }
+            count = static_cast<size_t>(std::min<uint64_t>(count, current->length_samples - render_position));
+        }
+        
+        int samples = current->engine->play(chunk, count);
+        if (samples <= 0) {
+            if (next) {
+                startQueuedTrack();
+            } else {
+                render_finished = true;
+                pcm_buffer->wake();
+            }
+            continue;
+        }
+        pcm_buffer->write(chunk, static_cast<size_t>(samples));
+        render_position += samples;
     }
 }
 
+void Player::applyCommand(PlayerCommand& command) {
+    switch (command.type) {
+        case PlayerCommand::Load:
+            rendering = false;
+            output_enabled = false;
+            retireSlot(std::move(current));
+            retireSlot(std::move(next));
+            current = std::move(command.slot);
+            render_position = 0;
+            skip_until = 0;
+            render_finished = false;
+            discardOutput(0);
+            break;
+            
+        case PlayerCommand::Queue:
+            retireSlot(std::move(next));
+            next = std::move(command.slot);
+            break;
+            
+        case PlayerCommand::Play:
+            if (current) {
+                rendering = true;
+                output_enabled = true;
+            }
+            break;
+            
+        case PlayerCommand::Pause:
+            output_enabled = false;
+            break;
+            
+        case PlayerCommand::Stop:
+            rendering = false;
+            output_enabled = false;
+            retireSlot(std::move(next));
+            if (current) {
+                rewindTrack();
+                discardOutput(0);
+            }
+            break;
+            
+        case PlayerCommand::SelectTrack:
+            retireSlot(std::move(next));
+            if (current) {
+                current->track = command.track;
+                current->length_samples = static_cast<uint64_t>(std::max<int64_t>(command.length_ms, 0)) * SAMPLE_RATE / 1000;
+                rewindTrack();
+                discardOutput(0);
+            }
+            break;
+            
+        case PlayerCommand::Seek:
+            if (current) {
+                // The emulation can only run forward, going back means starting over
+                uint64_t target = static_cast<uint64_t>(command.position_ms) * SAMPLE_RATE / 1000;
+                if (target < render_position || render_finished) {
+                    rewindTrack();
+                }
+                skip_until = target;
+                discardOutput(target);
+            }
+            break;
+            
+        case PlayerCommand::Quit:
+            should_quit = true;
+            break;
+            
+        case PlayerCommand::None:
+            break;
+    }
+    
+    pcm_buffer->wake();
+}
+
+void Player::rewindTrack() {
+    current->tune->selectSong(current->track);
+    current->engine->load(current->tune.get());
+    render_position = 0;
+    skip_until = 0;
+    render_finished = false;
+}
+
+void Player::startQueuedTrack() {
+    retireSlot(std::move(current));
+    current = std::move(next);
+    render_position = 0;
+    skip_until = 0;
+    render_finished = false;
+    
+    TrackBoundary boundary;
+    boundary.position = pcm_buffer->getWritePosition();
+    boundary.discards = pcm_buffer->getDiscardCount();
+    boundary.queue_id = current->queue_id;
+    // Only fails if the audio thread is gone, nobody would hear the switch then
+    boundaries.push(std::move(boundary));
+    pcm_buffer->wake();
+}
+
+void Player::discardOutput(uint64_t start_sample) {
+    // Published before the discard count the audio thread watches
+    output_start_sample = start_sample;
+    pcm_buffer->discard();
+}
+
+void Player::advanceToQueued(uint64_t queue_id) {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        // A load, stop or track change since the switch already replaced the state
+        if (queue_id != queued_id) {
+            return;
+        }
+        control_state.file = std::move(queued_state.file);
+        control_state.title = std::move(queued_state.title);
+        control_state.author = std::move(queued_state.author);
+        control_state.copyright = std::move(queued_state.copyright);
+        control_state.track = queued_state.track;
+        control_state.track_count = queued_state.track_count;
+        control_state.next_file.clear();
+        control_state.next_track = 0;
+        queued_id = 0;
+        publishState();
+    }
+    notifyStateChange();
+}
+
 void Player::audioThread() {
     pa_simple* pulse = nullptr;
     pa_sample_spec ss;
     ss.format = PA_SAMPLE_S16LE;
     ss.channels = 1;
-    ss.rate = 44100;
+    ss.rate = SAMPLE_RATE;
     
     int error;
     pulse = pa_simple_new(nullptr, "Nancy SID Player", PA_STREAM_PLAYBACK, nullptr, 
@@ -176,40 +609,132 @@ void Player::audioThread() {
         return;
     }
     
-    const int buffer_size = 1024;
-    short buffer[buffer_size];
+    short chunk[CHUNK_SAMPLES];
+    int shown_second = -1;
+    bool primed = false; // an empty buffer only counts as an underrun once output started
+    bool end_reported = false;
+    uint32_t seen_discards = pcm_buffer->getDiscardCount();
+    TrackBoundary boundary;
+    bool has_boundary = false;
+    auto written_at = std::chrono::steady_clock::now();
+    
+    // The queued tune becomes the current one once its first sample is
+    // audible, i.e. left the output's buffer: the latency measured after the
+    // last write, less what the output played since. The play time then
+    // restarts from that sample.
+    auto passBoundaries = [&]() {
+        auto idle = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - written_at);
+        int64_t latency_us = std::max<int64_t>(0, output_latency_us - idle.count());
+        size_t latency = static_cast<size_t>(latency_us * SAMPLE_RATE / 1000000);
+        size_t read_position = pcm_buffer->getReadPosition();
+        
+        while (has_boundary || boundaries.pop(boundary)) {
+            has_boundary = true;
+            int32_t age = static_cast<int32_t>(seen_discards - boundary.discards);
+            if (age > 0) {
+                has_boundary = false; // rendered before a discard, never played
+                continue;
+            }
+            if (age < 0 || read_position < boundary.position + latency) {
+                break;
+            }
+            has_boundary = false;
+            samples_played = read_position - boundary.position;
+            advanceToQueued(boundary.queue_id);
+        }
+    };
     
-    while (playing && !should_stop) {
-        if (paused) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // Sleeps until the ring changes. While the start of a queued tune only
+    // waits for the output to play it, wakes up a chunk later to look again.
+    auto waitForRing = [&](uint32_t token) {
+        passBoundaries();
+        if (has_boundary && boundary.discards == seen_discards && pcm_buffer->getReadPosition() >= boundary.position) {
+            std::this_thread::sleep_for(std::chrono::microseconds(CHUNK_SAMPLES * 1000000 / SAMPLE_RATE));
+        } else {
+            pcm_buffer->waitForChange(token);
+        }
+    };
+    
+    while (!should_quit) {
+        uint32_t token = pcm_buffer->getChangeToken();
+        if (should_quit) {
+            break;
+        }
+        
+        // A load, track change, seek or stop dropped the buffered audio: skip
+        // it, flush what PulseAudio still holds and continue at the new position
+        uint32_t discards = pcm_buffer->getDiscardCount();
+        if (discards != seen_discards) {
+            seen_discards = discards;
+            pcm_buffer->skipDiscarded();
+            pa_simple_flush(pulse, &error);
+            samples_played = output_start_sample.load();
+            output_latency_us = 0;
+            primed = false;
+            end_reported = false;
+            shown_second = getPlayTime();
+            notifyStateChange();
             continue;
         }
         
-        int samples = engine->play(buffer, buffer_size);
+        if (!output_enabled) {
+            waitForRing(token);
+            continue;
+        }
         
-        if (samples <= 0) {
-            break;
+        bool finished = render_finished;
+        
+        // Let the renderer fill the buffer before the first write. It stops
+        // once another chunk would cross the high-water mark.
+        if (!primed && !finished && pcm_buffer->getReadable() + CHUNK_SAMPLES <= high_water_mark) {
+            waitForRing(token);
+            continue;
         }
+        primed = true;
         
-        if (pa_simple_write(pulse, buffer, samples * sizeof(short), &error) < 0) {
+        size_t samples = pcm_buffer->read(chunk, CHUNK_SAMPLES);
+        if (samples == 0) {
+            if (!finished) {
+                underruns++;
+                primed = false;
+                notifyStateChange();
+            } else if (!end_reported) {
+                end_reported = true;
+                notifyStateChange(); // everything rendered has been played
+            }
+            waitForRing(token);
+            continue;
+        }
+        
+        // Blocks while PulseAudio's own buffer is full, which paces playback
+        if (pa_simple_write(pulse, chunk, samples * sizeof(short), &error) < 0) {
             break;
         }
+        samples_played += samples;
         
-        // Timing based on sample rate: 1024 samples at 44100 Hz = ~23ms
-        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        pa_usec_t latency = pa_simple_get_latency(pulse, &error);
+        if (latency != static_cast<pa_usec_t>(-1)) {
+            output_latency_us = static_cast<uint32_t>(latency);
+        }
+        written_at = std::chrono::steady_clock::now();
+        passBoundaries();
+        
+        int second = getPlayTime();
+        if (second != shown_second) {
+            shown_second = second;
+            notifyStateChange();
+        }
     }
     
-    if (pulse) {
-        pa_simple_drain(pulse, &error);
-        pa_simple_free(pulse);
+    pa_simple_free(pulse);
+    
+    if (!should_quit) {
+        notifyStateChange(); // the output failed
     }
 }
 
-void Player::updatePlayTime() {
-    while (playing && !should_stop) {
-        if (!paused) {
-            play_time++;
-        }
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+void Player::notifyStateChange() {
+    if (on_state_change) {
+        on_state_change();
     }
 }
\ No newline at end of file
@@ -0,0 +1,389 @@
+#include "render_command.h"
+#include "offline_renderer.h"
+#include "engine_slot.h"
+#include "work_stealing_pool.h"
+#include "mapped_file.h"
+#include "catalog.h"
+#include "search.h"
+#include "config.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <cstdio>
+#include <cstdlib>
+
+static void printRenderUsage() {
+    std::cerr << "Usage: nancyplayer render [options] <file.sid>\n"
+              << "  -t, --track N      subtune to render (default: the tune's start song)\n"
+              << "  -o, --output PATH  output file (default: <name>.wav or <name>-<track>.wav)\n"
+              << "  -l, --length SEC   length in seconds (default: from Songlengths.md5)\n"
+              << "  -r, --raw          write headerless 16-bit mono PCM, implied by a .raw output\n"
+              << "  -h, --help         show this help\n";
+}
+
+static bool parseNumber(const char* text, double& value) {
+    char* end = nullptr;
+    value = std::strtod(text, &end);
+    return end != text && *end == '\0' && value >= 0;
+}
+
+static std::string formatDuration(double seconds) {
+    int total = static_cast<int>(seconds + 0.5);
+    char text[32];
+    std::snprintf(text, sizeof(text), "%d:%02d", total / 60, total % 60);
+    return text;
+}
+
+int runRenderCommand(int argc, char** argv) {
+    RenderJob job;
+    bool raw = false;
+    
+    for (int i = 0; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        double number = 0;
+        
+        if (arg == "-h" || arg == "--help") {
+            printRenderUsage();
+            return 0;
+        } else if ((arg == "-t" || arg == "--track") && has_value && parseNumber(argv[i + 1], number) && number >= 1) {
+            job.track = static_cast<int>(number);
+            i++;
+        } else if ((arg == "-o" || arg == "--output") && has_value) {
+            job.output_path = argv[++i];
+        } else if ((arg == "-l" || arg == "--length") && has_value && parseNumber(argv[i + 1], number) && number > 0) {
+            job.length_ms = static_cast<int64_t>(number * 1000);
+            i++;
+        } else if (arg == "-r" || arg == "--raw") {
+            raw = true;
+        } else if (arg[0] != '-' && job.input_path.empty()) {
+            job.input_path = arg;
+        } else {
+            std::cerr << "render: unexpected argument '" << arg << "'\n";
+            printRenderUsage();
+            return 2;
+        }
+    }
+    
+    if (job.input_path.empty()) {
+        printRenderUsage();
+        return 2;
+    }
+    
+    std::filesystem::path output_path = job.output_path;
+    if (output_path.empty()) {
+        std::string name = std::filesystem::path(job.input_path).stem().string();
+        if (job.track > 0) {
+            name += "-" + std::to_string(job.track);
+        }
+        output_path = name + (raw ? ".raw" : ".wav");
+        job.output_path = output_path.string();
+    }
+    job.format = (raw || output_path.extension() == ".raw") ? PcmFormat::Raw : PcmFormat::Wav;
+    
+    // Look the tune up in the HVSC database unless the length was given
+    if (job.length_ms == 0) {
+        Config config;
+        config.loadConfig();
+        if (config.validateHvscRoot()) {
+            Catalog catalog;
+            catalog.load(config.getHvscRoot(), config.getCacheDir());
+            const SongEntry* song = catalog.findSong(catalog.toHvscPath(job.input_path));
+            if (song) {
+                job.song_lengths.assign(song->lengths.begin(), song->lengths.end());
+            }
+        }
+    }
+    
+    RenderStats stats;
+    std::string error;
+    if (!renderToFile(job, stats, error)) {
+        std::cerr << "render: " << error << std::endl;
+        if (job.length_ms == 0 && job.song_lengths.empty()) {
+            std::cerr << "render: the tune is not in Songlengths.md5, give its length with --length" << std::endl;
+        }
+        return 1;
+    }
+    
+    std::printf("%s track %d: %s rendered in %.2fs, %.1fx realtime -> %s\n",
+                job.input_path.c_str(), stats.track, formatDuration(stats.getRenderedSeconds(job.sample_rate)).c_str(),
+                stats.elapsed_seconds, stats.getRealtimeFactor(job.sample_rate), job.output_path.c_str());
+    return 0;
+}
+
+static void printBatchUsage() {
+    std::cerr << "Usage: nancyplayer batch [options] <directory>\n"
+              << "       nancyplayer batch [options] --query TEXT | --list FILE\n"
+              << "Renders every subtune of every tune, one emulation per worker thread.\n"
+              << "Finished files are skipped, so an interrupted batch resumes where it stopped.\n"
+              << "  -o, --output DIR   output directory (default: render)\n"
+              << "  -j, --jobs N       worker threads (default: one per core)\n"
+              << "  -q, --query TEXT   render the HVSC search results for TEXT\n"
+              << "  -f, --list FILE    render the files listed in FILE, one path per line\n"
+              << "  -l, --length SEC   length for tunes missing from Songlengths.md5 (default: skip them)\n"
+              << "  -r, --raw          write headerless 16-bit mono PCM instead of WAV\n"
+              << "  -h, --help         show this help\n";
+}
+
+// A tune to render in full; name is the output path below the output directory
+struct BatchTune {
+    std::string path;
+    std::string name;
+};
+
+static bool isSidFile(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".sid";
+}
+
+static void collectDirectory(const std::string& directory, std::vector<BatchTune>& tunes) {
+    std::error_code error;
+    auto options = std::filesystem::directory_options::skip_permission_denied;
+    for (std::filesystem::recursive_directory_iterator it(directory, options, error), end; it != end; it.increment(error)) {
+        if (error) {
+            break;
+        }
+        if (it->is_regular_file(error) && isSidFile(it->path())) {
+            std::string name = std::filesystem::relative(it->path(), directory, error).generic_string();
+            tunes.push_back({it->path().string(), name});
+        }
+    }
+    std::sort(tunes.begin(), tunes.end(), [](const BatchTune& a, const BatchTune& b) { return a.path < b.path; });
+}
+
+static bool collectList(const std::string& list_path, const std::string& hvsc_root, std::vector<BatchTune>& tunes) {
+    std::ifstream list(list_path);
+    if (!list) {
+        return false;
+    }
+    
+    // Lines are filesystem paths or, failing that, HVSC paths like /MUSICIANS/H/Hubbard_Rob/Commando.sid.
+    // Names keep the directories, like collectDirectory's, so tunes of the same
+    // name in different directories do not write to the same files.
+    std::string line;
+    while (std::getline(list, line)) {
+        line.erase(0, line.find_first_not_of(" \t"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::error_code error;
+        if (std::filesystem::is_regular_file(line, error)) {
+            // Below the HVSC root relative to it, elsewhere by the whole absolute path
+            std::filesystem::path path = std::filesystem::absolute(line, error).lexically_normal();
+            std::filesystem::path name = hvsc_root.empty() ? std::filesystem::path() : path.lexically_relative(std::filesystem::absolute(hvsc_root, error));
+            if (name.empty() || *name.begin() == "..") {
+                name = path;
+            }
+            tunes.push_back({path.string(), name.generic_string()});
+        } else if (!hvsc_root.empty()) {
+            std::filesystem::path name = std::filesystem::path(line).lexically_normal();
+            tunes.push_back({hvsc_root + (line[0] == '/' ? "" : "/") + line, name.generic_string()});
+        } else {
+            tunes.push_back({line, line});
+        }
+    }
+    return true;
+}
+
+// Subtune count of a tune that is not in Songlengths.md5, 0 if it cannot be parsed
+static int countSubtunes(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path)) {
+        return 0;
+    }
+    SidTune tune(reinterpret_cast<const uint_least8_t*>(file.getData()), static_cast<uint_least32_t>(file.getSize()));
+    const SidTuneInfo* info = tune.getStatus() ? tune.getInfo() : nullptr;
+    return info ? static_cast<int>(info->songs()) : 0;
+}
+
+int runBatchCommand(int argc, char** argv) {
+    std::string directory;
+    std::string query;
+    std::string list_path;
+    std::filesystem::path output_dir = "render";
+    int thread_count = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int64_t default_length_ms = 0;
+    bool raw = false;
+    
+    for (int i = 0; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        double number = 0;
+        
+        if (arg == "-h" || arg == "--help") {
+            printBatchUsage();
+            return 0;
+        } else if ((arg == "-o" || arg == "--output") && has_value) {
+            output_dir = argv[++i];
+        } else if ((arg == "-j" || arg == "--jobs") && has_value && parseNumber(argv[i + 1], number) && number >= 1) {
+            thread_count = static_cast<int>(number);
+            i++;
+        } else if ((arg == "-q" || arg == "--query") && has_value) {
+            query = argv[++i];
+        } else if ((arg == "-f" || arg == "--list") && has_value) {
+            list_path = argv[++i];
+        } else if ((arg == "-l" || arg == "--length") && has_value && parseNumber(argv[i + 1], number) && number > 0) {
+            default_length_ms = static_cast<int64_t>(number * 1000);
+            i++;
+        } else if (arg == "-r" || arg == "--raw") {
+            raw = true;
+        } else if (arg[0] != '-' && directory.empty()) {
+            directory = arg;
+        } else {
+            std::cerr << "batch: unexpected argument '" << arg << "'\n";
+            printBatchUsage();
+            return 2;
+        }
+    }
+    
+    int sources = !directory.empty() + !query.empty() + !list_path.empty();
+    if (sources != 1) {
+        printBatchUsage();
+        return 2;
+    }
+    
+    // The catalog supplies lengths and subtune counts, and the search for --query
+    Config config;
+    config.loadConfig();
+    auto catalog = std::make_shared<Catalog>();
+    bool have_catalog = config.validateHvscRoot() && catalog->load(config.getHvscRoot(), config.getCacheDir());
+    std::string hvsc_root = have_catalog ? catalog->getHvscRoot() : "";
+    
+    std::vector<BatchTune> tunes;
+    if (!query.empty()) {
+        if (!have_catalog) {
+            std::cerr << "batch: --query needs a valid HVSC root in the config" << std::endl;
+            return 1;
+        }
+        Search search;
+        search.setCatalog(catalog);
+        search.setResultLimit(0);
+        for (const auto& entry : search.search(query).entries) {
+            tunes.push_back({hvsc_root + std::string(entry.path), std::string(entry.path)});
+        }
+    } else if (!list_path.empty()) {
+        if (!collectList(list_path, hvsc_root, tunes)) {
+            std::cerr << "batch: cannot read " << list_path << std::endl;
+            return 1;
+        }
+    } else {
+        collectDirectory(directory, tunes);
+    }
+    
+    // Expand every tune into its subtunes
+    const char* extension = raw ? ".raw" : ".wav";
+    std::vector<RenderJob> jobs;
+    std::unordered_set<std::string> output_paths;
+    size_t unknown_length = 0;
+    size_t duplicates = 0;
+    for (const auto& tune : tunes) {
+        const SongEntry* song = have_catalog ? catalog->findSong(catalog->toHvscPath(tune.path)) : nullptr;
+        std::string name = song ? std::string(song->path) : tune.name;
+        name = std::filesystem::path(name).replace_extension().relative_path().generic_string();
+        
+        int subtunes = song ? static_cast<int>(song->lengths.size()) : 0;
+        if (!song && default_length_ms > 0) {
+            subtunes = countSubtunes(tune.path);
+        }
+        if (subtunes == 0) {
+            unknown_length++;
+        }
+        
+        for (int track = 1; track <= subtunes; track++) {
+            RenderJob job;
+            job.input_path = tune.path;
+            job.output_path = (output_dir / (name + "-" + std::to_string(track) + extension)).string();
+            job.track = track;
+            int seconds = song ? song->lengths[track - 1] : 0;
+            job.length_ms = seconds > 0 ? static_cast<int64_t>(seconds) * 1000 : default_length_ms;
+            job.format = raw ? PcmFormat::Raw : PcmFormat::Wav;
+            if (job.length_ms <= 0) {
+                continue;
+            }
+            // A tune listed twice would have two workers writing the same .part file
+            if (!output_paths.insert(job.output_path).second) {
+                duplicates++;
+                continue;
+            }
+            jobs.push_back(std::move(job));
+        }
+    }
+    if (unknown_length > 0) {
+        std::cerr << "batch: skipping " << unknown_length << " tunes of unknown length" << std::endl;
+    }
+    if (duplicates > 0) {
+        std::cerr << "batch: skipping " << duplicates << " duplicate subtunes" << std::endl;
+    }
+    
+    // Resume: whatever is already on disk was completed, partial output only ever exists as .part
+    size_t total_jobs = jobs.size();
+    std::erase_if(jobs, [](const RenderJob& job) { return std::filesystem::exists(job.output_path); });
+    size_t already_done = total_jobs - jobs.size();
+    
+    // Longest first, so the tail of the batch is made of short tunes that stealing can spread out
+    std::stable_sort(jobs.begin(), jobs.end(), [](const RenderJob& a, const RenderJob& b) { return a.length_ms > b.length_ms; });
+    
+    WorkStealingPool pool(std::min<int>(thread_count, static_cast<int>(std::max<size_t>(1, jobs.size()))));
+    std::vector<std::unique_ptr<EngineSlot>> slots(pool.getThreadCount());
+    std::mutex report_mutex;
+    size_t finished = 0;
+    size_t failed = 0;
+    uint64_t rendered_samples = 0;
+    
+    std::printf("Rendering %zu subtunes on %d threads (%zu already done) -> %s\n",
+                jobs.size(), pool.getThreadCount(), already_done, output_dir.string().c_str());
+    std::fflush(stdout);
+    auto started = std::chrono::steady_clock::now();
+    
+    pool.run(jobs.size(), [&](size_t index, int worker) {
+        RenderJob job = jobs[index];
+        std::string final_path = job.output_path;
+        job.output_path += ".part";
+        
+        // Each worker keeps its emulation for the whole batch
+        std::unique_ptr<EngineSlot>& slot = slots[worker];
+        if (!slot) {
+            slot = EngineSlot::create();
+        }
+        
+        RenderStats stats;
+        std::string error;
+        std::error_code fs_error;
+        std::filesystem::create_directories(std::filesystem::path(final_path).parent_path(), fs_error);
+        bool ok = slot && renderToFile(*slot, job, stats, error);
+        if (ok && std::rename(job.output_path.c_str(), final_path.c_str()) != 0) {
+            error = "cannot write " + final_path;
+            std::remove(job.output_path.c_str());
+            ok = false;
+        } else if (!slot) {
+            error = "cannot set up the emulation";
+        }
+        
+        std::lock_guard<std::mutex> lock(report_mutex);
+        finished++;
+        if (ok) {
+            rendered_samples += stats.samples;
+            std::printf("[%zu/%zu] %s  %s  %.1fx\n", finished, jobs.size(), final_path.c_str(),
+                        formatDuration(stats.getRenderedSeconds(job.sample_rate)).c_str(),
+                        stats.getRealtimeFactor(job.sample_rate));
+            std::fflush(stdout);
+        } else {
+            failed++;
+            std::cerr << "[" << finished << "/" << jobs.size() << "] " << error << std::endl;
+        }
+    });
+    
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    double audio_seconds = static_cast<double>(rendered_samples) / RenderJob().sample_rate;
+    std::printf("Rendered %zu of %zu subtunes, %s of audio in %.1fs, %.1fx realtime on %d threads (%zu steals)\n",
+                jobs.size() - failed, jobs.size(), formatDuration(audio_seconds).c_str(), elapsed,
+                elapsed > 0 ? audio_seconds / elapsed : 0, pool.getThreadCount(), pool.getStealCount());
+    return failed > 0 ? 1 : 0;
+}
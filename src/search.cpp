@@ -1,340 +1,435 @@
 #include "search.h"
-#include <fstream>
-#include <iostream>
-#include <sstream>
+#include "fuzzy_match.h"
 #include <algorithm>
-#include <filesystem>
 #include <cctype>
+#include <string_view>
 
-static std::ofstream debug_log("/tmp/nancyplayer_search_debug.log");
+Search::Search() : result_limit(1000) {
+}
 
-Search::Search() {
+// Packs three (already lowercased) bytes into one trigram key
+static inline uint32_t trigramKey(const char* p) {
+    return (static_cast<uint32_t>(static_cast<unsigned char>(p[0])) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(p[1])) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(p[2]));
 }
 
-bool Search::loadDatabase(const std::string& hvsc_root) {
-    try {
-        hvsc_root_path = std::filesystem::canonical(hvsc_root).string();
-    } catch (const std::filesystem::filesystem_error& e) {
-        hvsc_root_path = hvsc_root;
-    }
-    
-    // Look for Songlengths.md5 in common locations
-    std::vector<std::string> songlengths_paths = {
-        hvsc_root_path + "/DOCUMENTS/Songlengths.md5",
-        hvsc_root_path + "/Songlengths.md5",
-        hvsc_root_path + "/documents/Songlengths.md5",
-        hvsc_root_path + "/songlengths.md5"
-    };
-    
-    debug_log << "Searching for Songlengths.md5 in HVSC root: " << hvsc_root_path << std::endl;
-    
-    bool found_songlengths = false;
-    for (const auto& path : songlengths_paths) {
-        debug_log << "Checking: " << path << std::endl;
-        if (std::filesystem::exists(path)) {
-            debug_log << "Found Songlengths.md5 at: " << path << std::endl;
-            parseSonglengthsFile(path);
-            found_songlengths = true;
-            break;
-        }
+// HVSC files tunes by composer as /MUSICIANS/<letter>/<Surname_First>/...;
+// spelled out as "First Surname" so names match in reading order even for
+// tunes without STIL metadata. Empty outside MUSICIANS.
+static std::string composerFromPath(std::string_view path) {
+    const std::string_view prefix = "/MUSICIANS/";
+    if (path.substr(0, prefix.size()) != prefix) {
+        return "";
     }
-    
-    if (!found_songlengths) {
-        debug_log << "Songlengths.md5 not found in any expected location" << std::endl;
-        debug_log << "Search will only work with STIL data if available" << std::endl;
+    size_t letter_end = path.find('/', prefix.size());
+    size_t name_end = letter_end == std::string_view::npos ? letter_end : path.find('/', letter_end + 1);
+    if (name_end == std::string_view::npos) {
+        return "";
     }
+    std::string_view directory = path.substr(letter_end + 1, name_end - letter_end - 1);
     
-    // Also load STIL data for titles and artists
-    std::vector<std::string> stil_paths = {
-        hvsc_root_path + "/DOCUMENTS/STIL.txt",
-        hvsc_root_path + "/STIL.txt",
-        hvsc_root_path + "/documents/STIL.txt",
-        hvsc_root_path + "/stil.txt"
-    };
-    
-    for (const auto& path : stil_paths) {
-        if (std::filesystem::exists(path)) {
-            debug_log << "Found STIL database at: " << path << std::endl;
-            parseStilFile(path);
-            break;
-        }
+    std::string composer;
+    size_t first_name = directory.rfind('_');
+    if (first_name != std::string_view::npos) {
+        composer.append(directory.substr(first_name + 1)).append(" ");
+        directory = directory.substr(0, first_name);
     }
-    
-    return true;
+    composer.append(directory);
+    std::replace(composer.begin(), composer.end(), '_', ' ');
+    return composer;
 }
 
-void Search::parseSonglengthsFile(const std::string& songlengths_file_path) {
-    std::ifstream file(songlengths_file_path);
-    if (!file.is_open()) {
+static bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+        return ::tolower(static_cast<unsigned char>(x)) == ::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+void Search::setCatalog(std::shared_ptr<const Catalog> new_catalog) {
+    catalog = std::move(new_catalog);
+    buildIndex();
+}
+
+void Search::buildIndex() {
+    display_ranks.clear();
+    display_order.clear();
+    fuzzy_column.clear();
+    fuzzy_offsets.clear();
+    fuzzy_fields.clear();
+    fuzzy_masks.clear();
+    trigram_keys.clear();
+    trigram_offsets.clear();
+    trigram_postings.clear();
+    
+    if (!catalog) {
         return;
     }
     
-    std::string line;
-    std::string current_path;
+    const auto& songs = catalog->getSongs();
+    fuzzy_fields.reserve(songs.size());
+    fuzzy_offsets.reserve(songs.size() + 1);
     
-    while (std::getline(file, line)) {
-        // Skip empty lines
-        if (line.empty()) {
-            continue;
+    // Collect (trigram, song) pairs, then sort them into one flat posting array
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    for (size_t id = 0; id < songs.size(); id++) {
+        const SongEntry& entry = songs[id];
+        
+        // People type names before titles ("rhbmonty"), so the column reads
+        // artist, title, then path, in that order
+        std::string fuzzy_text = std::string(entry.artist());
+        std::string composer = composerFromPath(entry.path);
+        if (!composer.empty() && !equalsIgnoreCase(composer, entry.artist())) {
+            fuzzy_text.append(" ").append(composer);
         }
+        FuzzyFields fields;
+        fields.artist_end = static_cast<uint32_t>(entry.artist().size());
+        fields.title_begin = static_cast<uint32_t>(fuzzy_text.size() + 1);
+        fuzzy_text.append(" ").append(entry.title());
+        fields.title_end = static_cast<uint32_t>(fuzzy_text.size());
+        fuzzy_text.append(" ").append(entry.path);
+        fields.filename_begin = static_cast<uint32_t>(fuzzy_text.size() - entry.filename.size());
+        std::transform(fuzzy_text.begin(), fuzzy_text.end(), fuzzy_text.begin(), ::tolower);
         
-        // Check for comment lines that contain file paths
-        if (line[0] == ';' && line.find('/') != std::string::npos) {
-            // Extract path from comment line: "; /DEMOS/0-9/10_Orbyte.sid"
-            size_t path_start = line.find('/');
-            if (path_start != std::string::npos) {
-                current_path = line.substr(path_start);
-                // Remove any trailing whitespace
-                current_path.erase(current_path.find_last_not_of(" \t\r\n") + 1);
+        // Substring search covers the filename, title and artist, so only
+        // their trigrams are indexed
+        for (std::string_view field : substringFields(fuzzy_text, fields)) {
+            for (size_t i = 0; i + 3 <= field.size(); i++) {
+                pairs.emplace_back(trigramKey(field.data() + i), static_cast<uint32_t>(id));
             }
-            continue;
         }
-        
-        // Skip other comment lines
-        if (line[0] == ';') {
-            continue;
+        fuzzy_fields.push_back(fields);
+        fuzzy_offsets.push_back(static_cast<uint32_t>(fuzzy_column.size()));
+        fuzzy_masks.push_back(fuzzy::charMask(fuzzy_text));
+        fuzzy_column += fuzzy_text;
+    }
+    fuzzy_offsets.push_back(static_cast<uint32_t>(fuzzy_column.size()));
+    
+    // Rank every song by its folded display name once, so ordering hits later
+    // is an integer comparison instead of building and folding strings
+    {
+        std::vector<std::string> sort_keys;
+        sort_keys.reserve(songs.size());
+        for (const auto& entry : songs) {
+            std::string key = entry.getDisplayName();
+            std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+            sort_keys.push_back(std::move(key));
         }
         
-        // Parse MD5=length format
-        size_t equals_pos = line.find('=');
-        if (equals_pos == std::string::npos || current_path.empty()) {
-            continue;
+        display_order.resize(songs.size());
+        for (size_t id = 0; id < songs.size(); id++) {
+            display_order[id] = static_cast<uint32_t>(id);
         }
+        std::sort(display_order.begin(), display_order.end(), [&sort_keys](uint32_t a, uint32_t b) {
+            return sort_keys[a] < sort_keys[b];
+        });
         
-        std::string md5 = line.substr(0, equals_pos);
-        std::string length_str = line.substr(equals_pos + 1);
-        
-        // Parse length (format: mm:ss or mm:ss.ms)
-        std::vector<int> lengths;
-        size_t dot_pos = length_str.find('.');
-        if (dot_pos != std::string::npos) {
-            length_str = length_str.substr(0, dot_pos); // Remove milliseconds
+        display_ranks.resize(songs.size());
+        for (size_t rank = 0; rank < display_order.size(); rank++) {
+            display_ranks[display_order[rank]] = static_cast<uint32_t>(rank);
         }
-        
-        size_t colon_pos = length_str.find(':');
-        if (colon_pos != std::string::npos) {
-            int minutes = std::stoi(length_str.substr(0, colon_pos));
-            int seconds = std::stoi(length_str.substr(colon_pos + 1));
-            lengths.push_back(minutes * 60 + seconds);
+    }
+    
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    
+    trigram_postings.reserve(pairs.size());
+    for (const auto& [key, id] : pairs) {
+        if (trigram_keys.empty() || trigram_keys.back() != key) {
+            trigram_keys.push_back(key);
+            trigram_offsets.push_back(static_cast<uint32_t>(trigram_postings.size()));
         }
-        
-        // Create song entry
-        SongEntry entry;
-        entry.path = current_path;
-        entry.md5 = md5;
-        entry.lengths = lengths;
-        
-        // Extract filename
-        size_t last_slash = current_path.find_last_of('/');
-        if (last_slash != std::string::npos) {
-            entry.filename = current_path.substr(last_slash + 1);
-        } else {
-            entry.filename = current_path;
+        trigram_postings.push_back(id);
+    }
+    trigram_offsets.push_back(static_cast<uint32_t>(trigram_postings.size()));
+}
+
+std::vector<uint32_t> Search::allSongIds() const {
+    std::vector<uint32_t> ids(fuzzy_fields.size());
+    for (size_t id = 0; id < ids.size(); id++) {
+        ids[id] = static_cast<uint32_t>(id);
+    }
+    return ids;
+}
+
+std::vector<uint32_t> Search::findCandidates(const std::string& lower_query) const {
+    std::vector<uint32_t> candidates;
+    
+    // Queries shorter than a trigram cannot use the index, so every song is a candidate
+    if (lower_query.size() < 3) {
+        return allSongIds();
+    }
+    
+    // Look up the posting list of every query trigram; a missing one means no match
+    std::vector<std::pair<const uint32_t*, const uint32_t*>> lists;
+    for (size_t i = 0; i + 3 <= lower_query.size(); i++) {
+        uint32_t key = trigramKey(lower_query.data() + i);
+        auto it = std::lower_bound(trigram_keys.begin(), trigram_keys.end(), key);
+        if (it == trigram_keys.end() || *it != key) {
+            return candidates;
         }
-        
-        debug_log << "Parsed entry: " << current_path << " -> " << entry.filename << " (" << (lengths.empty() ? 0 : lengths[0]) << "s)" << std::endl;
-        
-        // Store in both maps
-        song_entries[current_path] = entry;
-        md5_to_path[md5] = current_path;
+        size_t slot = it - trigram_keys.begin();
+        lists.emplace_back(trigram_postings.data() + trigram_offsets[slot],
+                           trigram_postings.data() + trigram_offsets[slot + 1]);
     }
     
-    debug_log << "Loaded " << song_entries.size() << " song entries from Songlengths.md5" << std::endl;
+    // Intersect shortest lists first so the candidate set shrinks as fast as possible
+    std::sort(lists.begin(), lists.end(), [](const auto& a, const auto& b) {
+        return (a.second - a.first) < (b.second - b.first);
+    });
     
-    // Log first few entries for debugging
-    debug_log << "Sample song entries:" << std::endl;
-    int count = 0;
-    for (const auto& entry_pair : song_entries) {
-        if (count++ >= 5) break;
-        debug_log << "  Path: '" << entry_pair.first << "'" << std::endl;
-        debug_log << "  Filename: '" << entry_pair.second.filename << "'" << std::endl;
-        debug_log << "  Title: '" << entry_pair.second.title << "'" << std::endl;
-        debug_log << "  Artist: '" << entry_pair.second.artist << "'" << std::endl;
+    candidates.assign(lists[0].first, lists[0].second);
+    for (size_t l = 1; l < lists.size() && !candidates.empty(); l++) {
+        auto out = std::set_intersection(candidates.begin(), candidates.end(),
+                                         lists[l].first, lists[l].second, candidates.begin());
+        candidates.erase(out, candidates.end());
     }
+    
+    return candidates;
 }
 
-void Search::parseStilFile(const std::string& stil_file_path) {
-    std::ifstream file(stil_file_path);
-    if (!file.is_open()) {
-        return;
-    }
+bool Search::verifyCandidates(const std::vector<uint32_t>& candidates, const std::string& lower_query,
+                              std::vector<uint32_t>& matches, const SearchProgress& progress) const {
+    // Candidates are checked in batches so a background search can be
+    // cancelled or report partial results without a check per entry
+    const size_t batch_size = 4096;
     
-    std::string line;
-    std::string current_file;
-    std::string current_title;
-    std::string current_artist;
+    std::vector<uint64_t> page;
+    std::vector<uint64_t> batch_keys;
     
-    while (std::getline(file, line)) {
-        // Skip empty lines and comments
-        if (line.empty() || line[0] == '#') {
-            continue;
+    matches.clear();
+    for (size_t start = 0; start < candidates.size(); start += batch_size) {
+        if (progress.should_cancel && progress.should_cancel()) {
+            return false;
         }
         
-        // Check if this is a file path line (starts with /)
-        if (line[0] == '/') {
-            // Save previous entry if we have one
-            if (!current_file.empty() && song_entries.find(current_file) != song_entries.end()) {
-                song_entries[current_file].title = current_title;
-                song_entries[current_file].artist = current_artist;
+        // Trigrams only prove the pieces occur, so candidates are verified against the full text
+        size_t end = std::min(start + batch_size, candidates.size());
+        size_t batch_begin = matches.size();
+        for (size_t i = start; i < end; i++) {
+            uint32_t id = candidates[i];
+            for (std::string_view field : substringFields(songText(id), fuzzy_fields[id])) {
+                if (field.find(lower_query) != std::string_view::npos) {
+                    matches.push_back(id);
+                    break;
+                }
             }
-            
-            // Start new entry
-            current_file = line;
-            current_title.clear();
-            current_artist.clear();
-        }
-        // Check for field lines
-        else if (line.find("   TITLE: ") == 0) {
-            current_title = line.substr(10);
         }
-        else if (line.find("  ARTIST: ") == 0) {
-            current_artist = line.substr(10);
+        
+        if (progress.on_partial && end < candidates.size() && !matches.empty()) {
+            batch_keys.clear();
+            for (size_t i = batch_begin; i < matches.size(); i++) {
+                batch_keys.push_back(rankKey(matches[i], substringRelevance(matches[i], lower_query)));
+            }
+            publishPartial(page, batch_keys, matches.size(), progress);
         }
     }
-    
-    // Save last entry
-    if (!current_file.empty() && song_entries.find(current_file) != song_entries.end()) {
-        song_entries[current_file].title = current_title;
-        song_entries[current_file].artist = current_artist;
+    return true;
+}
+
+std::string_view Search::songText(uint32_t id) const {
+    return std::string_view(fuzzy_column.data() + fuzzy_offsets[id], fuzzy_offsets[id + 1] - fuzzy_offsets[id]);
+}
+
+std::array<std::string_view, 3> Search::substringFields(std::string_view text, const FuzzyFields& fields) {
+    return {text.substr(0, fields.artist_end),
+            text.substr(fields.title_begin, fields.title_end - fields.title_begin),
+            text.substr(fields.filename_begin)};
+}
+
+int Search::scoreFuzzy(uint32_t id, const std::string& pattern) const {
+    std::string_view text = songText(id);
+    int score = fuzzy::score(text, pattern);
+    if (score <= 0) {
+        return score;
     }
     
-    debug_log << "Enhanced song entries with STIL data" << std::endl;
+    // A match inside the title or filename alone counts double, so a tight
+    // hit there beats one scattered over artist, title and directories
+    const FuzzyFields& fields = fuzzy_fields[id];
+    std::string_view title = text.substr(fields.title_begin, fields.title_end - fields.title_begin);
+    int field_score = std::max(fuzzy::score(title, pattern), fuzzy::score(text.substr(fields.filename_begin), pattern));
+    return std::max(score, 2 * field_score);
 }
 
-void Search::indexLocalSidFiles(const std::string& directory) {
-    debug_log << "Indexing local SID files in: " << directory << std::endl;
+bool Search::scoreFuzzyCandidates(const std::vector<uint32_t>& candidates, const std::string& pattern,
+                                  std::vector<uint32_t>& matches, std::vector<uint32_t>& scores,
+                                  const SearchProgress& progress) const {
+    const size_t batch_size = 4096;
+    uint32_t pattern_mask = fuzzy::charMask(pattern);
+    std::vector<uint32_t> survivors;
+    std::vector<uint64_t> page;
+    std::vector<uint64_t> batch_keys;
     
-    try {
-        for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
-            if (entry.is_regular_file()) {
-                std::string path = entry.path().string();
-                std::string extension = entry.path().extension().string();
-                
-                // Convert extension to lowercase for comparison
-                std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
-                
-                if (extension == ".sid") {
-                    // Create song entry for SID file
-                    SongEntry song_entry;
-                    song_entry.path = "/" + std::filesystem::relative(entry.path(), directory).string();
-                    song_entry.filename = entry.path().filename().string();
-                    song_entry.md5 = ""; // No MD5 available
-                    
-                    // Replace backslashes with forward slashes (Windows compatibility)
-                    std::replace(song_entry.path.begin(), song_entry.path.end(), '\\', '/');
-                    
-                    debug_log << "Indexed SID file: " << song_entry.path << " (" << song_entry.filename << ")" << std::endl;
-                    
-                    song_entries[song_entry.path] = song_entry;
-                }
+    matches.clear();
+    scores.clear();
+    for (size_t start = 0; start < candidates.size(); start += batch_size) {
+        if (progress.should_cancel && progress.should_cancel()) {
+            return false;
+        }
+        
+        // Cheap vectorized character-set test first, full subsequence scoring only for survivors
+        size_t count = std::min(batch_size, candidates.size() - start);
+        survivors.clear();
+        fuzzy::filterByMask(fuzzy_masks.data(), candidates.data() + start, count, pattern_mask, survivors);
+        
+        size_t batch_begin = matches.size();
+        for (uint32_t id : survivors) {
+            int score = scoreFuzzy(id, pattern);
+            if (score > 0) {
+                matches.push_back(id);
+                scores.push_back(static_cast<uint32_t>(score));
+            }
+        }
+        
+        if (progress.on_partial && start + count < candidates.size() && !matches.empty()) {
+            batch_keys.clear();
+            for (size_t i = batch_begin; i < matches.size(); i++) {
+                batch_keys.push_back(rankKey(matches[i], UINT32_MAX - scores[i]));
             }
+            publishPartial(page, batch_keys, matches.size(), progress);
         }
-    } catch (const std::filesystem::filesystem_error& e) {
-        debug_log << "Error indexing directory: " << e.what() << std::endl;
     }
-    
-    debug_log << "Indexed " << song_entries.size() << " local SID files" << std::endl;
+    return true;
 }
 
-std::vector<SongEntry> Search::search(const std::string& query) const {
-    std::vector<SongEntry> results;
-    
-    debug_log << "Search called with query: '" << query << "'" << std::endl;
-    debug_log << "Song entries count: " << song_entries.size() << std::endl;
-    
-    if (query.empty()) {
-        debug_log << "Empty query, returning empty results" << std::endl;
-        return results;
+SearchResults Search::search(const std::string& query) const {
+    SearchSession session;
+    return search(query, session, SearchProgress{});
+}
+
+SearchResults Search::search(const std::string& query, SearchSession& session) const {
+    return search(query, session, SearchProgress{});
+}
+
+SearchResults Search::search(const std::string& query, SearchSession& session, const SearchProgress& progress,
+                             SearchMode mode) const {
+    if (query.empty() || !catalog) {
+        session.reset();
+        return {};
     }
     
     // Convert query to lowercase for case-insensitive search
     std::string lower_query = query;
     std::transform(lower_query.begin(), lower_query.end(), lower_query.begin(), ::tolower);
     
-    debug_log << "Searching for: '" << lower_query << "'" << std::endl;
-    
-    for (const auto& entry_pair : song_entries) {
-        const SongEntry& entry = entry_pair.second;
-        
-        // Search in filename, title, and artist
-        std::string search_text = entry.filename + " " + entry.title + " " + entry.artist;
-        std::transform(search_text.begin(), search_text.end(), search_text.begin(), ::tolower);
-        
-        if (search_text.find(lower_query) != std::string::npos) {
-            debug_log << "Found match: " << entry.filename << std::endl;
-            results.push_back(entry);
+    // Spaces only separate words for the reader; fuzzy patterns skip them
+    if (mode == SearchMode::Fuzzy) {
+        lower_query.erase(std::remove(lower_query.begin(), lower_query.end(), ' '), lower_query.end());
+        if (lower_query.empty()) {
+            session.reset();
+            return {};
         }
     }
     
-    debug_log << "Search returned " << results.size() << " results" << std::endl;
+    // Appending characters can only narrow the result in both modes, so refine
+    // the previous matches; anything else (backspace, edits, a new catalog or
+    // mode) starts over
+    bool refine = session.catalog == catalog.get() &&
+                  session.mode == mode &&
+                  !session.lower_query.empty() &&
+                  lower_query.size() >= session.lower_query.size() &&
+                  lower_query.compare(0, session.lower_query.size(), session.lower_query) == 0;
     
-    // Sort results by relevance (prefer title/artist matches over filename)
-    std::sort(results.begin(), results.end(), [&lower_query](const SongEntry& a, const SongEntry& b) {
-        std::string a_title_artist = a.title + " " + a.artist;
-        std::string b_title_artist = b.title + " " + b.artist;
-        std::transform(a_title_artist.begin(), a_title_artist.end(), a_title_artist.begin(), ::tolower);
-        std::transform(b_title_artist.begin(), b_title_artist.end(), b_title_artist.begin(), ::tolower);
-        
-        bool a_in_title_artist = a_title_artist.find(lower_query) != std::string::npos;
-        bool b_in_title_artist = b_title_artist.find(lower_query) != std::string::npos;
-        
-        if (a_in_title_artist && !b_in_title_artist) return true;
-        if (!a_in_title_artist && b_in_title_artist) return false;
-        
-        return a.getDisplayName() < b.getDisplayName();
-    });
+    std::vector<uint32_t> matches;
+    std::vector<uint32_t> scores;
+    bool completed;
+    if (mode == SearchMode::Fuzzy) {
+        completed = scoreFuzzyCandidates(refine ? session.matches : allSongIds(), lower_query, matches, scores, progress);
+    } else {
+        completed = verifyCandidates(refine ? session.matches : findCandidates(lower_query), lower_query, matches, progress);
+    }
     
+    if (!completed) {
+        // Cancelled: leave the session at the last query that completed
+        return {};
+    }
+    
+    session.catalog = catalog.get();
+    session.mode = mode;
+    session.lower_query = lower_query;
+    session.matches = matches;
+    
+    return rankResults(matches, scores, lower_query);
+}
+
+// One packed key per hit: relevance (high word, lower is better), then
+// display-name order (low word, which also identifies the song)
+uint64_t Search::rankKey(uint32_t id, uint32_t relevance) const {
+    return (static_cast<uint64_t>(relevance) << 32) | display_ranks[id];
+}
+
+// Substring hits in the title or artist rank above those in the path alone
+uint32_t Search::substringRelevance(uint32_t id, const std::string& lower_query) const {
+    auto fields = substringFields(songText(id), fuzzy_fields[id]);
+    bool in_title_or_artist = fields[0].find(lower_query) != std::string_view::npos ||
+                              fields[1].find(lower_query) != std::string_view::npos;
+    return in_title_or_artist ? 0 : 1;
+}
+
+void Search::publishPartial(std::vector<uint64_t>& page, std::vector<uint64_t>& batch_keys, size_t total_matches,
+                            const SearchProgress& progress) const {
+    // Only the new batch is ranked and merged into the page published last
+    // time, so a broad query does not re-rank every match found so far
+    size_t count = result_limit ? std::min(result_limit, batch_keys.size()) : batch_keys.size();
+    std::partial_sort(batch_keys.begin(), batch_keys.begin() + count, batch_keys.end());
+    size_t middle = page.size();
+    page.insert(page.end(), batch_keys.begin(), batch_keys.begin() + count);
+    std::inplace_merge(page.begin(), page.begin() + middle, page.end());
+    if (result_limit && page.size() > result_limit) {
+        page.resize(result_limit);
+    }
+    progress.on_partial(pageResults(page, total_matches));
+}
+
+SearchResults Search::pageResults(const std::vector<uint64_t>& sorted_keys, size_t total_matches) const {
+    const auto& songs = catalog->getSongs();
+    SearchResults results;
+    results.total_matches = total_matches;
+    results.entries.reserve(sorted_keys.size());
+    for (uint64_t key : sorted_keys) {
+        results.entries.push_back(songs[display_order[static_cast<uint32_t>(key)]]);
+    }
     return results;
 }
 
-SongEntry Search::getSongInfo(const std::string& sid_file_path) const {
-    std::string normalized_path = normalizePathForLookup(sid_file_path);
-    auto it = song_entries.find(normalized_path);
-    if (it != song_entries.end()) {
-        return it->second;
+SearchResults Search::rankResults(const std::vector<uint32_t>& matches, const std::vector<uint32_t>& scores,
+                                  const std::string& lower_query) const {
+    // Fuzzy hits are ranked by score, substring hits prefer title/artist matches
+    std::vector<uint64_t> keys;
+    keys.reserve(matches.size());
+    for (size_t i = 0; i < matches.size(); i++) {
+        uint32_t id = matches[i];
+        keys.push_back(rankKey(id, scores.empty() ? substringRelevance(id, lower_query) : UINT32_MAX - scores[i]));
     }
-    return SongEntry{};
+    
+    // Only the visible page needs ordering, so broad queries avoid a full sort
+    size_t count = result_limit ? std::min(result_limit, keys.size()) : keys.size();
+    std::partial_sort(keys.begin(), keys.begin() + count, keys.end());
+    keys.resize(count);
+    
+    return pageResults(keys, matches.size());
+}
+
+const SongEntry* Search::findSongInfo(const std::string& sid_file_path) const {
+    return catalog ? catalog->findSong(catalog->toHvscPath(sid_file_path)) : nullptr;
 }
 
-bool Search::hasSongInfo(const std::string& sid_file_path) const {
-    std::string normalized_path = normalizePathForLookup(sid_file_path);
-    return song_entries.find(normalized_path) != song_entries.end();
+const SongEntry* Search::findSongInfoByHvscPath(std::string_view hvsc_path) const {
+    return catalog ? catalog->findSong(hvsc_path) : nullptr;
 }
 
 int Search::getSongLength(const std::string& sid_file_path, int track) const {
-    std::string normalized_path = normalizePathForLookup(sid_file_path);
-    auto it = song_entries.find(normalized_path);
-    if (it != song_entries.end() && track >= 1 && track <= (int)it->second.lengths.size()) {
-        return it->second.lengths[track - 1]; // Convert to 0-based index
+    if (!catalog) {
+        return 0;
     }
-    return 0;
+    return getSongLengthByHvscPath(catalog->toHvscPath(sid_file_path), track);
 }
 
-std::string Search::normalizePathForLookup(const std::string& sid_file_path) const {
-    try {
-        // If the path is already absolute, use it directly
-        std::filesystem::path abs_path;
-        if (std::filesystem::path(sid_file_path).is_absolute()) {
-            abs_path = std::filesystem::canonical(sid_file_path);
-        } else {
-            abs_path = std::filesystem::canonical(std::filesystem::current_path() / sid_file_path);
-        }
-        
-        std::filesystem::path hvsc_path = std::filesystem::path(hvsc_root_path);
-        
-        // Get relative path from HVSC root
-        std::filesystem::path rel_path = std::filesystem::relative(abs_path, hvsc_path);
-        
-        // Convert to HVSC format (forward slashes, leading slash)
-        std::string hvsc_path_str = "/" + rel_path.string();
-        
-        // Replace backslashes with forward slashes (Windows compatibility)
-        std::replace(hvsc_path_str.begin(), hvsc_path_str.end(), '\\', '/');
-        
-        debug_log << "Path normalization: '" << sid_file_path << "' -> '" << hvsc_path_str << "'" << std::endl;
-        return hvsc_path_str;
-    } catch (const std::filesystem::filesystem_error& e) {
-        debug_log << "Path normalization failed for '" << sid_file_path << "': " << e.what() << std::endl;
-        return "";
+int Search::getSongLengthByHvscPath(std::string_view hvsc_path, int track) const {
+    const SongEntry* entry = findSongInfoByHvscPath(hvsc_path);
+    if (entry && track >= 1 && track <= (int)entry->lengths.size()) {
+        return entry->lengths[track - 1]; // Convert to 0-based index
     }
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "search_worker.h"
+
+SearchWorker::SearchWorker() : pending_mode(SearchMode::Substring), has_pending(false), running(false), stopping(false), generation(0), busy(false), has_update(false) {
+    thread = std::thread(&SearchWorker::workerLoop, this);
+}
+
+SearchWorker::~SearchWorker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        generation++;
+    }
+    wake.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void SearchWorker::setSearch(std::shared_ptr<const Search> new_search) {
+    std::lock_guard<std::mutex> lock(mutex);
+    search = std::move(new_search);
+}
+
+void SearchWorker::setOnUpdate(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(mutex);
+    on_update = std::move(callback);
+}
+
+void SearchWorker::submit(const std::string& query, SearchMode mode) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending_query = query;
+        pending_mode = mode;
+        has_pending = true;
+        busy = true;
+        generation++; // cancels whatever is running
+    }
+    wake.notify_one();
+}
+
+void SearchWorker::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    has_pending = false;
+    busy = running;
+    generation++;
+    published = SearchResults{};
+    has_update = false;
+}
+
+bool SearchWorker::poll(SearchResults& results) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!has_update) {
+        return false;
+    }
+    results = std::move(published);
+    published = SearchResults{};
+    has_update = false;
+    return true;
+}
+
+void SearchWorker::publish(uint64_t for_generation, SearchResults&& results) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Drop results of a query that was superseded while it ran
+    if (for_generation != generation) {
+        return;
+    }
+    published = std::move(results);
+    has_update = true;
+    if (on_update) {
+        on_update();
+    }
+}
+
+void SearchWorker::workerLoop() {
+    while (true) {
+        std::shared_ptr<const Search> current_search;
+        std::string query;
+        SearchMode mode;
+        uint64_t query_generation;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            bool was_running = running;
+            running = false;
+            busy = has_pending;
+            if (was_running && !busy && on_update) {
+                on_update(); // lets the UI stop showing the query as running
+            }
+            wake.wait(lock, [this] { return has_pending || stopping; });
+            if (stopping) {
+                return;
+            }
+            query = std::move(pending_query);
+            mode = pending_mode;
+            current_search = search;
+            has_pending = false;
+            running = true;
+            query_generation = generation;
+        }
+        
+        SearchProgress progress;
+        progress.should_cancel = [this, query_generation] { return generation != query_generation; };
+        progress.on_partial = [this, query_generation](SearchResults&& partial) {
+            publish(query_generation, std::move(partial));
+        };
+        
+        // Without a loaded database every query simply has no results
+        SearchResults results;
+        if (current_search) {
+            results = current_search->search(query, session, progress, mode);
+        }
+        if (!progress.should_cancel()) {
+            publish(query_generation, std::move(results));
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "sid_tune_cache.h"
+#include "mapped_file.h"
+#include <algorithm>
+
+SidTuneCache::SidTuneCache(size_t capacity) : capacity(std::max<size_t>(capacity, 1)) {
+}
+
+std::unique_ptr<SidTune> SidTuneCache::take(const std::string& path, SourceStamp& stamp) {
+    if (!SourceStamp::read(path, stamp)) {
+        return nullptr;
+    }
+    
+    auto found = index.find(path);
+    if (found != index.end()) {
+        std::list<Entry>::iterator entry = found->second;
+        std::unique_ptr<SidTune> tune = std::move(entry->tune);
+        bool unchanged = entry->stamp == stamp;
+        index.erase(found);
+        entries.erase(entry);
+        if (unchanged) {
+            return tune;
+        }
+    }
+    
+    // SidTune copies what it needs, so the mapping only lives while parsing
+    MappedFile file;
+    if (!file.open(path)) {
+        return nullptr;
+    }
+    auto tune = std::make_unique<SidTune>(reinterpret_cast<const uint_least8_t*>(file.getData()),
+                                          static_cast<uint_least32_t>(file.getSize()));
+    if (!tune->getStatus()) {
+        return nullptr;
+    }
+    return tune;
+}
+
+void SidTuneCache::put(const std::string& path, const SourceStamp& stamp, std::unique_ptr<SidTune> tune) {
+    if (!tune) {
+        return;
+    }
+    
+    // The same file may have been taken twice, keep the one returned last
+    auto found = index.find(path);
+    if (found != index.end()) {
+        entries.erase(found->second);
+        index.erase(found);
+    }
+    
+    entries.push_front(Entry{path, stamp, std::move(tune)});
+    index[path] = entries.begin();
+    
+    if (entries.size() > capacity) {
+        index.erase(entries.back().path);
+        entries.pop_back();
+    }
+}
+
+void SidTuneCache::clear() {
+    index.clear();
+    entries.clear();
+}
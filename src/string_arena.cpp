@@ -0,0 +1,61 @@
+#include "string_arena.h"
+#include <cstring>
+
+StringArena::StringArena(size_t block_size) : block_size(block_size), block_used(block_size), bytes_allocated(0) {
+}
+
+std::string_view StringArena::store(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view();
+    }
+    
+    // Oversized strings get a block of their own so the current block keeps filling
+    if (text.size() > block_size / 4) {
+        blocks.emplace_back(new char[text.size()]);
+        bytes_allocated += text.size();
+        std::memcpy(blocks.back().get(), text.data(), text.size());
+        std::string_view stored(blocks.back().get(), text.size());
+        
+        // Keep the partially filled block last
+        if (blocks.size() > 1) {
+            std::swap(blocks[blocks.size() - 1], blocks[blocks.size() - 2]);
+        }
+        return stored;
+    }
+    
+    if (block_used + text.size() > block_size) {
+        blocks.emplace_back(new char[block_size]);
+        bytes_allocated += block_size;
+        block_used = 0;
+    }
+    
+    char* destination = blocks.back().get() + block_used;
+    std::memcpy(destination, text.data(), text.size());
+    block_used += text.size();
+    return std::string_view(destination, text.size());
+}
+
+void StringArena::adopt(StringArena&& other) {
+    // Insert the adopted blocks in front so our partially filled block stays last
+    blocks.insert(blocks.begin(), std::make_move_iterator(other.blocks.begin()), std::make_move_iterator(other.blocks.end()));
+    bytes_allocated += other.bytes_allocated;
+    other.blocks.clear();
+    other.block_used = other.block_size;
+    other.bytes_allocated = 0;
+}
+
+void StringArena::clear() {
+    blocks.clear();
+    block_used = block_size;
+    bytes_allocated = 0;
+}
+
+std::string_view StringInterner::intern(std::string_view text) {
+    auto it = pool.find(text);
+    if (it != pool.end()) {
+        return *it;
+    }
+    std::string_view stored = arena.store(text);
+    pool.insert(stored);
+    return stored;
+}
\ No newline at end of file
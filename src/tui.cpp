@@ -3,17 +3,38 @@
 #include "file_browser.h"
 #include "stil_reader.h"
 #include "search.h"
+#include "search_worker.h"
+#include "catalog.h"
 #include "config.h"
+#include "event_loop.h"
 #include <algorithm>
 #include <iostream>
+#include <cstdio>
+#include <csignal>
+#include <sys/ioctl.h>
+#include <unistd.h>
 
-TUI::TUI() : running(false), search_mode(false), search_selected(0), next_color_pair(1), browser_start_line(0), search_start_line(0), search_win(nullptr) {
+static const int64_t SEEK_STEP_MS = 10000;
+
+TUI::TUI() : loader_percent(0), loader_updates(0), database_ready(false), shown_loader_updates(0), playlist_index(-1),
+             dirty(DIRTY_ALL), shown_play_time(-1), shown_underruns(0), shown_search_busy(false), running(false), search_mode(false), search_fuzzy(false), search_total_matches(0), search_selected(0), next_color_pair(1), browser_start_line(0), search_start_line(0), search_win(nullptr) {
+    // SIGWINCH goes through the event loop, so block it before any thread starts
+    events = std::make_unique<EventLoop>();
+    wakeup = std::make_unique<EventNotifier>();
+    events->watchSignal(SIGWINCH, [this] {
+        struct winsize size;
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0) {
+            resizeterm(size.ws_row, size.ws_col);
+        }
+        handleResize();
+    });
+    
     initscr();
     cbreak();
     noecho();
     curs_set(0);
     keypad(stdscr, TRUE);
-    timeout(100);
+    timeout(0); // keys are read when the event loop reports stdin readable
     
     initColors();
     
@@ -22,13 +43,31 @@ TUI::TUI() : running(false), search_mode(false), search_selected(0), next_color_
     player = std::make_unique<Player>();
     browser = std::make_unique<FileBrowser>();
     stil_reader = std::make_unique<StilReader>();
-    search = std::make_unique<Search>();
+    search = std::make_shared<Search>();
+    search_worker = std::make_unique<SearchWorker>();
     config = std::make_unique<Config>();
     
+    player->setOnStateChange([this] { wakeup->notify(); });
+    length_search = search;
+    player->setSongLengthLookup([this](const std::string& filename, int track) {
+        std::shared_ptr<const Search> lengths = length_search.load();
+        return static_cast<int64_t>(lengths->getSongLength(filename, track)) * 1000;
+    });
+    shown_state = player->getState();
+    search_worker->setOnUpdate([this] { wakeup->notify(); });
+    events->watch(STDIN_FILENO, [this] { handleInput(); });
+    events->watch(*wakeup, nullptr); // the loop polls player and workers after every wake-up
+    
     initWindows();
 }
 
 TUI::~TUI() {
+    // The player's threads look up song lengths in length_search, so they
+    // have to stop before it goes
+    player.reset();
+    if (loader_thread.joinable()) {
+        loader_thread.join();
+    }
     destroySearchWindow();
     destroyWindows();
     endwin();
@@ -112,12 +151,14 @@ void TUI::createSearchWindow() {
     box(search_win, 0, 0);
     
     keypad(search_win, TRUE);
+    markDirty(DIRTY_ALL);
 }
 
 void TUI::destroySearchWindow() {
     if (search_win) {
         delwin(search_win);
         search_win = nullptr;
+        markDirty(DIRTY_ALL); // uncovers the panels below
     }
 }
 
@@ -141,33 +182,209 @@ void TUI::run() {
         return;
     }
     
+    player->setBufferLength(config->getAudioBufferMs());
+    browser->setHvscRoot(config->getHvscRoot());
     browser->setDirectory(config->getHvscRoot());
-    stil_reader->loadDatabase(config->getHvscRoot());
-    search->loadDatabase(config->getHvscRoot());
+    
+    // The browser works without the databases, so show it right away
+    startDatabaseLoader();
     
     refresh();
     
+    // Sleep until a key, a resize or a notification from the player or a
+    // background worker; nothing here runs on a timer
     while (running) {
-        handleInput();
-        handleResize();
+        events->wait();
+        pollDatabaseLoader();
+        pollSearchResults();
+        pollPlayerState();
         refresh();
     }
 }
 
+void TUI::startDatabaseLoader() {
+    std::string hvsc_root = config->getHvscRoot();
+    std::string cache_dir = config->getCacheDir();
+    
+    {
+        std::lock_guard<std::mutex> lock(loader_mutex);
+        loader_stage = "Starting";
+        loader_percent = 0;
+    }
+    
+    loader_thread = std::thread([this, hvsc_root, cache_dir] {
+        auto report = [this](const char* stage, int percent) {
+            std::lock_guard<std::mutex> lock(loader_mutex);
+            loader_stage = stage;
+            loader_percent = percent;
+            loader_updates++;
+            wakeup->notify();
+        };
+        
+        // Parse the HVSC documents once and share them between STIL info and search
+        auto catalog = std::make_shared<Catalog>();
+        catalog->load(hvsc_root, cache_dir, report);
+        
+        report("Building search index", 100);
+        auto new_search = std::make_shared<Search>();
+        new_search->setCatalog(catalog);
+        
+        std::lock_guard<std::mutex> lock(loader_mutex);
+        loaded_catalog = std::move(catalog);
+        loaded_search = std::move(new_search);
+        wakeup->notify();
+    });
+}
+
+void TUI::pollDatabaseLoader() {
+    if (database_ready) {
+        return;
+    }
+    
+    std::shared_ptr<Catalog> catalog;
+    std::shared_ptr<Search> new_search;
+    {
+        std::lock_guard<std::mutex> lock(loader_mutex);
+        if (loader_updates != shown_loader_updates) {
+            shown_loader_updates = loader_updates;
+            markDirty(DIRTY_STATUS);
+        }
+        if (!loaded_search) {
+            return;
+        }
+        catalog = std::move(loaded_catalog);
+        new_search = std::move(loaded_search);
+    }
+    
+    loader_thread.join();
+    stil_reader->setCatalog(catalog);
+    search = new_search;
+    length_search = new_search;
+    search_worker->setSearch(new_search);
+    database_ready = true;
+    markDirty(DIRTY_ALL);
+    
+    // Re-run whatever was typed while the database was still loading
+    if (search_mode && !search_query.empty()) {
+        search_worker->submit(search_query, search_fuzzy ? SearchMode::Fuzzy : SearchMode::Substring);
+    }
+}
+
+void TUI::pollSearchResults() {
+    // The worker wakes the event loop for every page it publishes and once it goes idle
+    bool busy = search_worker->isBusy();
+    if (busy != shown_search_busy) {
+        shown_search_busy = busy;
+        markDirty(DIRTY_SEARCH);
+    }
+    
+    SearchResults update;
+    if (search_worker->poll(update)) {
+        search_results = std::move(update.entries);
+        search_total_matches = update.total_matches;
+        if (search_selected >= (int)search_results.size()) {
+            search_selected = std::max(0, (int)search_results.size() - 1);
+        }
+        markDirty(DIRTY_SEARCH);
+    }
+}
+
+void TUI::pollPlayerState() {
+    std::shared_ptr<const PlayerState> state = player->getState();
+    int play_time = player->getPlayTime();
+    uint64_t underruns = player->getUnderrunCount();
+    
+    bool changed = state->version != shown_state->version;
+    if (changed) {
+        markDirty(DIRTY_INFO | DIRTY_STATUS);
+        
+        // The player moved on to the queued file by itself
+        if (state->file != shown_state->file && playlist_index >= 0 && playlist_index + 1 < (int)playlist.size() &&
+            playlist[playlist_index + 1].path == state->file) {
+            playlist_index++;
+            playing_hvsc_path = playlist[playlist_index].hvsc_path;
+        }
+    }
+    if (play_time != shown_play_time || underruns != shown_underruns) {
+        markDirty(DIRTY_STATUS);
+    }
+    
+    shown_state = std::move(state);
+    shown_play_time = play_time;
+    shown_underruns = underruns;
+    
+    if (changed) {
+        queueNextTune();
+    }
+}
+
+void TUI::startPlayback(const std::string& path, const std::string& hvsc_path) {
+    playing_hvsc_path = hvsc_path;
+    
+    playlist.clear();
+    playlist_index = -1;
+    for (const auto& entry : browser->getEntries()) {
+        if (entry.is_sid_file) {
+            if (entry.path == path || (!hvsc_path.empty() && entry.hvsc_path == hvsc_path)) {
+                playlist_index = static_cast<int>(playlist.size());
+            }
+            playlist.push_back(entry);
+        }
+    }
+    
+    player->loadFile(path);
+    player->play();
+}
+
+void TUI::queueNextTune() {
+    const PlayerState& state = *shown_state;
+    if (!state.playing) {
+        return;
+    }
+    
+    // The next subtune, then the first subtune of the next file
+    std::string next_file;
+    int next_track = 0;
+    if (state.track < state.track_count) {
+        next_file = state.file;
+        next_track = state.track + 1;
+    } else if (playlist_index >= 0 && playlist_index + 1 < (int)playlist.size()) {
+        next_file = playlist[playlist_index + 1].path;
+        next_track = 1;
+    }
+    
+    if (next_file.empty() || (next_file == state.next_file && next_track == state.next_track)) {
+        return;
+    }
+    player->queueFile(next_file, next_track);
+}
+
 void TUI::refresh() {
     // Safety check - don't draw if windows aren't initialized
     if (!header_win || !browser_win || !separator_win || !stil_win || !status_win || !help_win) {
         return;
     }
     
-    drawHeader();
-    drawBrowser();
-    drawSeparator();
-    drawStilInfo();
-    drawStatus();
-    drawHelp();
+    // The search popup sits on top of the panels, so it has to be drawn again
+    // whenever one of them paints over it
+    if (search_mode && (dirty & (DIRTY_BROWSER | DIRTY_SEPARATOR | DIRTY_INFO))) {
+        dirty |= DIRTY_SEARCH;
+    }
+    if (dirty == 0) {
+        return;
+    }
+    
+    unsigned regions = dirty;
+    dirty = 0;
     
-    if (search_mode) {
+    if (regions & DIRTY_HEADER) drawHeader();
+    if (regions & DIRTY_BROWSER) drawBrowser();
+    if (regions & DIRTY_SEPARATOR) drawSeparator();
+    if (regions & DIRTY_INFO) drawStilInfo();
+    if (regions & DIRTY_STATUS) drawStatus();
+    if (regions & DIRTY_HELP) drawHelp();
+    
+    if (search_mode && (regions & DIRTY_SEARCH)) {
         drawSearchResults();
     }
     
@@ -184,7 +401,9 @@ void TUI::drawHeader() {
     wattron(header_win, COLOR_PAIR(getColorPair(theme.top_bar.fg, theme.top_bar.bg)));
     mvwprintw(header_win, 0, 0, "%-*s", width, "");
     
-    std::string relative_path = config->getRelativeToHvsc(browser->getCurrentPath());
+    // Relative to the HVSC root like Config::getRelativeToHvsc, but resolved once per directory scan
+    const std::string& hvsc_path = browser->getCurrentHvscPath();
+    std::string relative_path = hvsc_path.empty() ? browser->getCurrentPath() : hvsc_path == "/" ? "." : hvsc_path.substr(1);
     mvwprintw(header_win, 0, 0, "Nancy SID Player - %s", relative_path.c_str());
     
     wattroff(header_win, COLOR_PAIR(getColorPair(theme.top_bar.fg, theme.top_bar.bg)));
@@ -315,9 +534,10 @@ void TUI::drawStilInfo() {
     int line = 0;
     
     // Player Information Section
-    if (!player->getCurrentFile().empty()) {
+    const PlayerState& state = *shown_state;
+    if (!state.file.empty()) {
         // Get relative file path
-        std::string relative_file = config->getRelativeToHvsc(player->getCurrentFile());
+        std::string_view relative_file = playing_hvsc_path.empty() ? std::string_view(state.file) : std::string_view(playing_hvsc_path).substr(1);
         
         // File
         wattron(stil_win, COLOR_PAIR(getColorPair(theme.header.fg, theme.header.bg)));
@@ -327,8 +547,7 @@ void TUI::drawStilInfo() {
         mvwprintw(stil_win, line, 10, ": ");
         wattroff(stil_win, COLOR_PAIR(getColorPair(theme.colon.fg, theme.colon.bg)));
         wattron(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
-        std::string cropped_file = cropTextLeft(relative_file, width - 12);
-        mvwprintw(stil_win, line++, 12, "%s", cropped_file.c_str());
+        printCroppedLeft(stil_win, line++, 12, relative_file, width - 12);
         wattroff(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
         
         // Title
@@ -339,8 +558,7 @@ void TUI::drawStilInfo() {
         mvwprintw(stil_win, line, 10, ": ");
         wattroff(stil_win, COLOR_PAIR(getColorPair(theme.colon.fg, theme.colon.bg)));
         wattron(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
-        std::string cropped_title = cropTextLeft(player->getTitle(), width - 12);
-        mvwprintw(stil_win, line++, 12, "%s", cropped_title.c_str());
+        printCroppedLeft(stil_win, line++, 12, state.title, width - 12);
         wattroff(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
         
         // Author
@@ -351,8 +569,7 @@ void TUI::drawStilInfo() {
         mvwprintw(stil_win, line, 10, ": ");
         wattroff(stil_win, COLOR_PAIR(getColorPair(theme.colon.fg, theme.colon.bg)));
         wattron(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
-        std::string cropped_author = cropTextLeft(player->getAuthor(), width - 12);
-        mvwprintw(stil_win, line++, 12, "%s", cropped_author.c_str());
+        printCroppedLeft(stil_win, line++, 12, state.author, width - 12);
         wattroff(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
         
         // Copyright
@@ -363,8 +580,7 @@ void TUI::drawStilInfo() {
         mvwprintw(stil_win, line, 10, ": ");
         wattroff(stil_win, COLOR_PAIR(getColorPair(theme.colon.fg, theme.colon.bg)));
         wattron(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
-        std::string cropped_copyright = cropTextLeft(player->getCopyright(), width - 12);
-        mvwprintw(stil_win, line++, 12, "%s", cropped_copyright.c_str());
+        printCroppedLeft(stil_win, line++, 12, state.copyright, width - 12);
         wattroff(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
         
         // Track
@@ -375,7 +591,7 @@ void TUI::drawStilInfo() {
         mvwprintw(stil_win, line, 10, ": ");
         wattroff(stil_win, COLOR_PAIR(getColorPair(theme.colon.fg, theme.colon.bg)));
         wattron(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
-        mvwprintw(stil_win, line++, 12, "%d/%d", player->getCurrentTrack(), player->getTrackCount());
+        mvwprintw(stil_win, line++, 12, "%d/%d", state.track, state.track_count);
         wattroff(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
         
         line++; // Empty line separator
@@ -387,10 +603,12 @@ void TUI::drawStilInfo() {
     }
     
     // STIL Information Section
-    std::string selected_file = browser->getSelectedFile();
+    const FileEntry* selected_entry = browser->getSelectedEntry();
+    
+    const StilEntry* stil_info = selected_entry ? stil_reader->findInfoByHvscPath(selected_entry->hvsc_path) : nullptr;
     
-    if (!selected_file.empty() && stil_reader->hasInfo(selected_file)) {
-        StilEntry info = stil_reader->getInfo(selected_file);
+    if (stil_info) {
+        const StilEntry& info = *stil_info;
         
         mvwprintw(stil_win, line++, 1, "STIL Information");
         line++;
@@ -403,8 +621,7 @@ void TUI::drawStilInfo() {
             mvwprintw(stil_win, line, 10, ": ");
             wattroff(stil_win, COLOR_PAIR(getColorPair(theme.colon.fg, theme.colon.bg)));
             wattron(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
-            std::string cropped_stil_title = cropTextLeft(info.title, width - 12);
-            mvwprintw(stil_win, line++, 12, "%s", cropped_stil_title.c_str());
+            printCroppedLeft(stil_win, line++, 12, info.title, width - 12);
             wattroff(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
         }
         if (!info.artist.empty()) {
@@ -415,8 +632,7 @@ void TUI::drawStilInfo() {
             mvwprintw(stil_win, line, 10, ": ");
             wattroff(stil_win, COLOR_PAIR(getColorPair(theme.colon.fg, theme.colon.bg)));
             wattron(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
-            std::string cropped_stil_artist = cropTextLeft(info.artist, width - 12);
-            mvwprintw(stil_win, line++, 12, "%s", cropped_stil_artist.c_str());
+            printCroppedLeft(stil_win, line++, 12, info.artist, width - 12);
             wattroff(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
         }
         if (!info.copyright.empty()) {
@@ -427,8 +643,7 @@ void TUI::drawStilInfo() {
             mvwprintw(stil_win, line, 10, ": ");
             wattroff(stil_win, COLOR_PAIR(getColorPair(theme.colon.fg, theme.colon.bg)));
             wattron(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
-            std::string cropped_stil_copyright = cropTextLeft(info.copyright, width - 12);
-            mvwprintw(stil_win, line++, 12, "%s", cropped_stil_copyright.c_str());
+            printCroppedLeft(stil_win, line++, 12, info.copyright, width - 12);
             wattroff(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
         }
         
@@ -442,7 +657,7 @@ void TUI::drawStilInfo() {
             wattroff(stil_win, COLOR_PAIR(getColorPair(theme.header.fg, theme.header.bg)));
             
             // Word wrap the comment
-            std::string comment = info.comment;
+            std::string_view comment = info.comment;
             int max_width = width - 3;
             size_t pos = 0;
             while (pos < comment.length() && line < height - 1) {
@@ -453,9 +668,9 @@ void TUI::drawStilInfo() {
                     if (end == pos) end = pos + max_width; // Force break if no space
                 }
                 
-                std::string line_text = comment.substr(pos, end - pos);
+                std::string_view line_text = comment.substr(pos, end - pos);
                 wattron(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
-                mvwprintw(stil_win, line++, 3, "%s", line_text.c_str());
+                mvwprintw(stil_win, line++, 3, "%.*s", static_cast<int>(line_text.length()), line_text.data());
                 wattroff(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
                 pos = end + 1; // Skip the space
             }
@@ -468,12 +683,19 @@ void TUI::drawStilInfo() {
             wattroff(stil_win, COLOR_PAIR(getColorPair(theme.header.fg, theme.header.bg)));
             for (size_t i = 0; i < info.subtune_info.size() && line < height - 1; i++) {
                 wattron(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
-                std::string subtune_text = std::to_string(i + 1) + ": " + info.subtune_info[i];
-                std::string cropped_subtune = cropTextLeft(subtune_text, width - 3);
-                mvwprintw(stil_win, line++, 3, "%s", cropped_subtune.c_str());
+                char number[16];
+                int number_length = std::snprintf(number, sizeof(number), "%zu: ", i + 1);
+                mvwprintw(stil_win, line, 3, "%s", number);
+                printCroppedLeft(stil_win, line++, 3 + number_length, info.subtune_info[i], width - 3 - number_length);
                 wattroff(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
             }
         }
+    } else if (!database_ready) {
+        mvwprintw(stil_win, line++, 1, "STIL Information");
+        line++;
+        wattron(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
+        mvwprintw(stil_win, line++, 1, "Loading STIL database...");
+        wattroff(stil_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
     } else {
         mvwprintw(stil_win, line++, 1, "STIL Information");
         line++;
@@ -501,18 +723,25 @@ void TUI::drawStatus() {
     mvwprintw(status_win, 0, 0, "%-*s", width, "");
     
     if (search_mode) {
-        mvwprintw(status_win, 0, 0, "Search: %s", search_query.c_str());
+        mvwprintw(status_win, 0, 0, "%s: %s", search_fuzzy ? "Fuzzy search" : "Search", search_query.c_str());
     } else {
-        // Left side: File count
-        mvwprintw(status_win, 0, 0, "Files: %zu", browser->getEntries().size());
+        // Left side: File count, plus database progress while it loads
+        if (database_ready) {
+            mvwprintw(status_win, 0, 0, "Files: %zu", browser->getEntries().size());
+        } else {
+            std::lock_guard<std::mutex> lock(loader_mutex);
+            mvwprintw(status_win, 0, 0, "Files: %zu | Loading database: %s (%d%%)",
+                      browser->getEntries().size(), loader_stage.c_str(), loader_percent);
+        }
         
         // Right side: Time and Status (if playing)
-        if (!player->getCurrentFile().empty()) {
-            int minutes = player->getPlayTime() / 60;
-            int seconds = player->getPlayTime() % 60;
+        const PlayerState& state = *shown_state;
+        if (!state.file.empty()) {
+            int minutes = shown_play_time / 60;
+            int seconds = shown_play_time % 60;
             
             // Get song length from search database
-            int song_length = search->getSongLength(player->getCurrentFile(), player->getCurrentTrack());
+            int song_length = search->getSongLengthByHvscPath(playing_hvsc_path, state.track);
             std::string time_str;
             if (song_length > 0) {
                 int length_minutes = song_length / 60;
@@ -523,8 +752,11 @@ void TUI::drawStatus() {
                 time_str = std::to_string(minutes) + ":" + (seconds < 10 ? "0" : "") + std::to_string(seconds);
             }
             
-            std::string status = player->isPlaying() ? (player->isPaused() ? "PAUSED" : "PLAYING") : "STOPPED";
+            std::string status = state.playing ? (state.paused ? "PAUSED" : "PLAYING") : "STOPPED";
             std::string status_info = time_str + " [" + status + "]";
+            if (shown_underruns > 0) {
+                status_info += " " + std::to_string(shown_underruns) + " underruns";
+            }
             
             // Right align the status info
             int status_len = status_info.length();
@@ -545,9 +777,9 @@ void TUI::drawHelp() {
     wbkgd(help_win, COLOR_PAIR(getColorPair(theme.bottom_bar.fg, theme.bottom_bar.bg)));
     
     if (search_mode) {
-        mvwprintw(help_win, 0, 0, "j/k: Up/Down | ENTER: Play | ESC: Exit search | Type to search | SPACE: Pause/Resume | s: Stop | J/K: Next/Prev track | q: Quit");
+        mvwprintw(help_win, 0, 0, "j/k: Up/Down | ENTER: Play | ESC: Exit search | TAB: Fuzzy/Exact | Type to search | SPACE: Pause/Resume | s: Stop | J/K: Next/Prev track | q: Quit");
     } else {
-        mvwprintw(help_win, 0, 0, "j/k: Up/Down | h: Parent dir | l/ENTER: Play/Enter dir | /: Search | SPACE: Pause/Resume | s: Stop | J/K: Next/Prev track | q: Quit");
+        mvwprintw(help_win, 0, 0, "j/k: Up/Down | h: Parent dir | l/ENTER: Play/Enter dir | /: Search | SPACE: Pause/Resume | s: Stop | J/K: Next/Prev track | H/L: Seek | q: Quit");
     }
     
     wnoutrefresh(help_win);
@@ -589,13 +821,21 @@ void TUI::drawSearchResults() {
     
     // Header line
     wattron(search_win, COLOR_PAIR(getColorPair(theme.header.fg, theme.header.bg)));
-    mvwprintw(search_win, 1, 2, "Search: %s", search_query.c_str());
-    mvwprintw(search_win, 2, 2, "Results (%zu found):", search_results.size());
+    mvwprintw(search_win, 1, 2, "%s: %s", search_fuzzy ? "Fuzzy search" : "Search", search_query.c_str());
+    if (search_worker->isBusy()) {
+        mvwprintw(search_win, 2, 2, "Results (%zu so far, searching...):", search_total_matches);
+    } else if (search_total_matches > search_results.size()) {
+        mvwprintw(search_win, 2, 2, "Results (%zu found, top %zu shown):", search_total_matches, search_results.size());
+    } else {
+        mvwprintw(search_win, 2, 2, "Results (%zu found):", search_total_matches);
+    }
     wattroff(search_win, COLOR_PAIR(getColorPair(theme.header.fg, theme.header.bg)));
     
     if (search_results.empty()) {
         wattron(search_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
-        mvwprintw(search_win, 4, 2, "No results found");
+        const char* message = !database_ready ? "Loading database..." :
+                              search_worker->isBusy() ? "Searching..." : "No results found";
+        mvwprintw(search_win, 4, 2, "%s", message);
         wattroff(search_win, COLOR_PAIR(getColorPair(theme.value.fg, theme.value.bg)));
         wnoutrefresh(search_win);
         return;
@@ -630,8 +870,8 @@ void TUI::drawSearchResults() {
         int line = i + 4; // Start after header lines
         
         // Extract directory path and filename
-        std::string full_path = entry.path;
-        std::string filename = entry.filename;
+        std::string full_path(entry.path);
+        std::string filename(entry.filename);
         std::string directory_path = full_path.substr(0, full_path.length() - filename.length());
         
         // Combine directory and filename for cropping calculation
@@ -688,24 +928,41 @@ void TUI::drawSearchResults() {
 }
 
 void TUI::handleInput() {
-    int ch = getch();
-    
+    // ncurses may have buffered several keys from one read, so take them all
+    int ch;
+    while (running && (ch = getch()) != ERR) {
+        handleKey(ch);
+    }
+}
+
+void TUI::handleKey(int ch) {
     if (search_mode) {
+        // The query and selection show in the popup and the status bar
+        markDirty(DIRTY_SEARCH | DIRTY_STATUS);
+        
         switch (ch) {
             case 27: // ESC
                 search_mode = false;
                 search_query.clear();
+                search_worker->cancel();
                 search_results.clear();
+                search_total_matches = 0;
                 search_selected = 0;
                 destroySearchWindow();
                 break;
                 
+            case '\t':
+                search_fuzzy = !search_fuzzy;
+                search_worker->submit(search_query, search_fuzzy ? SearchMode::Fuzzy : SearchMode::Substring);
+                search_selected = 0;
+                break;
+                
             case KEY_BACKSPACE:
             case 127:
             case '\b':
                 if (!search_query.empty()) {
                     search_query.pop_back();
-                    search_results = search->search(search_query);
+                    search_worker->submit(search_query, search_fuzzy ? SearchMode::Fuzzy : SearchMode::Substring);
                     search_selected = 0;
                 }
                 break;
@@ -715,7 +972,7 @@ void TUI::handleInput() {
             case KEY_ENTER:
                 if (!search_results.empty() && search_selected < (int)search_results.size()) {
                     const auto& entry = search_results[search_selected];
-                    std::string full_path = entry.path;
+                    std::string full_path(entry.path);
                     // Convert HVSC path to absolute path by adding HVSC root
                     if (full_path[0] == '/') {
                         full_path = config->getHvscRoot() + full_path;
@@ -725,12 +982,13 @@ void TUI::handleInput() {
                     browser->navigateToFile(full_path);
                     
                     // Load and play the file
-                    player->loadFile(full_path);
-                    player->play();
+                    startPlayback(full_path, std::string(entry.path));
                     
                     search_mode = false;
                     search_query.clear();
+                    search_worker->cancel();
                     search_results.clear();
+                    search_total_matches = 0;
                     search_selected = 0;
                     destroySearchWindow();
                 }
@@ -751,14 +1009,17 @@ void TUI::handleInput() {
                 break;
                 
             case ' ':
-                if (player->isPlaying()) {
-                    if (player->isPaused()) {
+                {
+                    std::shared_ptr<const PlayerState> state = player->getState();
+                    if (state->playing) {
+                        if (state->paused) {
+                            player->play();
+                        } else {
+                            player->pause();
+                        }
+                    } else if (!state->file.empty()) {
                         player->play();
-                    } else {
-                        player->pause();
                     }
-                } else if (!player->getCurrentFile().empty()) {
-                    player->play();
                 }
                 break;
                 
@@ -783,7 +1044,7 @@ void TUI::handleInput() {
             default:
                 if (ch >= 32 && ch <= 126) { // Printable characters
                     search_query += (char)ch;
-                    search_results = search->search(search_query);
+                    search_worker->submit(search_query, search_fuzzy ? SearchMode::Fuzzy : SearchMode::Substring);
                     search_selected = 0;
                 }
                 break;
@@ -798,7 +1059,9 @@ void TUI::handleInput() {
             case '/':
                 search_mode = true;
                 search_query.clear();
+                search_worker->cancel();
                 search_results.clear();
+                search_total_matches = 0;
                 search_selected = 0;
                 createSearchWindow();
                 break;
@@ -807,17 +1070,20 @@ void TUI::handleInput() {
             case 'j':
             case KEY_DOWN:
                 browser->moveDown();
+                markDirty(DIRTY_BROWSER | DIRTY_INFO);
                 break;
                 
             case 'k':
             case KEY_UP:
                 browser->moveUp();
+                markDirty(DIRTY_BROWSER | DIRTY_INFO);
                 break;
                 
             case 'h':
             case KEY_BACKSPACE:
             case 127:
                 browser->goToParent();
+                markDirty(DIRTY_HEADER | DIRTY_BROWSER | DIRTY_INFO | DIRTY_STATUS);
                 break;
                 
             case 'l':
@@ -825,27 +1091,31 @@ void TUI::handleInput() {
             case '\r':
             case KEY_ENTER:
                 {
-                    std::string selected = browser->getSelectedFile();
-                    if (!selected.empty()) {
-                        if (std::filesystem::is_directory(selected)) {
+                    const FileEntry* selected = browser->getSelectedEntry();
+                    if (selected) {
+                        if (selected->is_directory) {
                             browser->enterDirectory();
+                            markDirty(DIRTY_HEADER | DIRTY_BROWSER | DIRTY_INFO | DIRTY_STATUS);
                         } else {
-                            player->loadFile(selected);
-                            player->play();
+                            startPlayback(selected->path, selected->hvsc_path);
+                            markDirty(DIRTY_INFO | DIRTY_STATUS);
                         }
                     }
                 }
                 break;
                 
             case ' ':
-                if (player->isPlaying()) {
-                    if (player->isPaused()) {
+                {
+                    std::shared_ptr<const PlayerState> state = player->getState();
+                    if (state->playing) {
+                        if (state->paused) {
+                            player->play();
+                        } else {
+                            player->pause();
+                        }
+                    } else if (!state->file.empty()) {
                         player->play();
-                    } else {
-                        player->pause();
                     }
-                } else if (!player->getCurrentFile().empty()) {
-                    player->play();
                 }
                 break;
                 
@@ -861,6 +1131,14 @@ void TUI::handleInput() {
             case 'K':
                 player->prevTrack();
                 break;
+                
+            case 'H':
+                player->seek(player->getPlayTimeMs() - SEEK_STEP_MS);
+                break;
+                
+            case 'L':
+                player->seek(player->getPlayTimeMs() + SEEK_STEP_MS);
+                break;
         }
     }
 }
@@ -905,6 +1183,7 @@ void TUI::handleResize() {
         
         // Force a complete redraw
         clearok(stdscr, TRUE);
+        markDirty(DIRTY_ALL);
         refresh();
     }
 }
@@ -914,11 +1193,24 @@ void TUI::resetScrollPositions() {
     search_start_line = 0;
 }
 
-std::string TUI::cropTextLeft(const std::string& text, int max_width) {
+std::string TUI::cropTextLeft(std::string_view text, int max_width) {
     if (text.length() <= max_width) {
-        return text;
+        return std::string(text);
     }
     
     // Crop from left and add ellipsis
-    return "..." + text.substr(text.length() - max_width + 3);
+    return std::string("...").append(text.substr(text.length() - max_width + 3));
+}
+
+// Prints text like cropTextLeft would return it, without building a string
+void TUI::printCroppedLeft(WINDOW* win, int y, int x, std::string_view text, int max_width) {
+    max_width = std::max(max_width, 0);
+    if (text.length() <= static_cast<size_t>(max_width)) {
+        mvwprintw(win, y, x, "%.*s", static_cast<int>(text.length()), text.data());
+    } else if (max_width < 3) {
+        mvwprintw(win, y, x, "%.*s", max_width, "...");
+    } else {
+        std::string_view tail = text.substr(text.length() - static_cast<size_t>(max_width - 3));
+        mvwprintw(win, y, x, "...%.*s", static_cast<int>(tail.length()), tail.data());
+    }
 }
@@ -0,0 +1,61 @@
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(int thread_count) : steals(0) {
+    int count = std::max(1, thread_count);
+    for (int i = 0; i < count; i++) {
+        shares.push_back(std::make_unique<Share>());
+    }
+}
+
+void WorkStealingPool::run(size_t task_count, const Task& task) {
+    for (size_t i = 0; i < task_count; i++) {
+        shares[i % shares.size()]->tasks.push_back(i);
+    }
+    
+    // The calling thread works as worker 0
+    std::vector<std::thread> threads;
+    for (int worker = 1; worker < getThreadCount(); worker++) {
+        threads.emplace_back(&WorkStealingPool::workerLoop, this, worker, std::cref(task));
+    }
+    workerLoop(0, task);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+bool WorkStealingPool::popOwn(int worker, size_t& task) {
+    Share& share = *shares[worker];
+    std::lock_guard<std::mutex> lock(share.mutex);
+    if (share.tasks.empty()) {
+        return false;
+    }
+    task = share.tasks.front();
+    share.tasks.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::steal(int worker, size_t& task) {
+    // Start with the next worker so thieves spread over different victims
+    int count = getThreadCount();
+    for (int offset = 1; offset < count; offset++) {
+        Share& victim = *shares[(worker + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(int worker, const Task& task) {
+    // No task creates new ones, so a worker that finds every share empty is done
+    size_t index = 0;
+    while (popOwn(worker, index) || steal(worker, index)) {
+        task(index, worker);
+    }
+}
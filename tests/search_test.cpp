@@ -0,0 +1,110 @@
+// Checks the fuzzy search examples the feature was specified with against a
+// small HVSC tree written to a temporary directory.
+
+#include "catalog.h"
+#include "search.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+static const char* const MONTY = "/MUSICIANS/H/Hubbard_Rob/Monty_on_the_Run.sid";
+
+static const char* const SONGLENGTHS =
+    "[Database]\n"
+    "; /MUSICIANS/H/Hubbard_Rob/Monty_on_the_Run.sid\n"
+    "00000000000000000000000000000001=5:50\n"
+    "; /MUSICIANS/H/Hubbard_Rob/Commando.sid\n"
+    "00000000000000000000000000000002=4:00 0:12\n"
+    "; /MUSICIANS/H/Hubbard_Rob/Delta.sid\n"
+    "00000000000000000000000000000003=3:00\n"
+    "; /MUSICIANS/G/Galway_Martin/Wizball.sid\n"
+    "00000000000000000000000000000004=4:20\n"
+    "; /MUSICIANS/D/Daglish_Ben/Last_Ninja.sid\n"
+    "00000000000000000000000000000005=2:30\n"
+    "; /GAMES/M-R/Ninja.sid\n"
+    "00000000000000000000000000000006=3:10\n";
+
+// TITLE and ARTIST as the real STIL spells them, plus a decoy whose title
+// and path together hold "mntyrn" ("monty /games/m-r/ninja.sid") with
+// smaller gaps than Monty on the Run's filename, but neither field alone
+static const char* const STIL =
+    "### STIL ###\n"
+    "\n"
+    "/MUSICIANS/H/Hubbard_Rob/Monty_on_the_Run.sid\n"
+    "   TITLE: Monty on the Run\n"
+    "  ARTIST: Rob Hubbard\n"
+    "\n"
+    "/GAMES/M-R/Ninja.sid\n"
+    "   TITLE: Monty\n";
+
+static int failures = 0;
+
+static void writeFile(const std::filesystem::path& path, const std::string& text) {
+    std::ofstream file(path, std::ios::binary);
+    file << text;
+}
+
+static void expectFound(const Search& search, const std::string& query, const std::string& expected_path,
+                        const std::string& setup) {
+    SearchSession session;
+    SearchResults results = search.search(query, session, SearchProgress(), SearchMode::Fuzzy);
+    for (const auto& entry : results.entries) {
+        if (entry.path == expected_path) {
+            return;
+        }
+    }
+    std::cerr << "FAIL " << setup << ": fuzzy '" << query << "' does not find " << expected_path << std::endl;
+    failures++;
+}
+
+static void expectFirst(const Search& search, const std::string& query, const std::string& expected_path,
+                        const std::string& setup) {
+    SearchSession session;
+    SearchResults results = search.search(query, session, SearchProgress(), SearchMode::Fuzzy);
+    std::string first = results.entries.empty() ? "(no match)" : std::string(results.entries[0].path);
+    if (first != expected_path) {
+        std::cerr << "FAIL " << setup << ": fuzzy '" << query << "' ranks " << first
+                  << " first, expected " << expected_path << std::endl;
+        failures++;
+    }
+}
+
+static void runChecks(const std::filesystem::path& root, const std::string& stil, const std::string& setup) {
+    writeFile(root / "DOCUMENTS" / "Songlengths.md5", SONGLENGTHS);
+    writeFile(root / "DOCUMENTS" / "STIL.txt", stil);
+    
+    auto catalog = std::make_shared<Catalog>();
+    if (!catalog->load(root.string())) {
+        std::cerr << "FAIL " << setup << ": catalog did not load" << std::endl;
+        failures++;
+        return;
+    }
+    Search search;
+    search.setCatalog(catalog);
+    
+    // The examples from the fuzzy search request and the README. "mnd" fits
+    // Commando by the same composer more tightly, so only finding is required.
+    expectFound(search, "rhbmnd", MONTY, setup);
+    expectFirst(search, "rhbmonty", MONTY, setup);
+    
+    // A tight match in the filename must beat one scattered over fields
+    expectFirst(search, "mntyrn", MONTY, setup);
+}
+
+int main() {
+    std::filesystem::path root = std::filesystem::temp_directory_path() /
+                                 ("nancyplayer_search_test_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(root / "DOCUMENTS");
+    
+    runChecks(root, STIL, "with STIL");
+    runChecks(root, "", "without STIL");
+    
+    std::filesystem::remove_all(root);
+    if (failures == 0) {
+        std::cout << "search_test: all checks passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
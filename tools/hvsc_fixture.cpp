@@ -0,0 +1,532 @@
+// Generates a synthetic HVSC tree for reproducible performance measurements:
+// MUSICIANS, GAMES and DEMOS with minimal but valid PSID files, plus a
+// matching DOCUMENTS/Songlengths.md5 and DOCUMENTS/STIL.txt. The same size
+// and seed always produce the same tree.
+//
+// The shape follows the real collection: most tunes sit below a composer's
+// directory, a few composers wrote most of them, about one tune in five has
+// several subtunes, lengths cluster around two to three minutes and roughly
+// a third of all tunes have a STIL entry.
+//
+// Usage: nancyplayer_hvsc_fixture [--songs N] [--seed N] [--no-files] <output dir>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+static const char* const FIRST_NAMES[] = {
+    "Rob", "Martin", "Ben", "David", "Tim", "Jeroen", "Chris", "Matt", "Fred", "Johannes",
+    "Jens", "Richard", "Mark", "Paul", "Steve", "Anders", "Thomas", "Peter", "Michael", "Jonathan",
+    "Markus", "Stefan", "Lars", "Mikko", "Glenn", "Reyn", "Neil", "Jason", "Adam", "Linus",
+};
+
+static const char* const NAME_SYLLABLES[] = {
+    "hub", "bard", "gal", "way", "dag", "lish", "whit", "ta", "ker", "fol", "lin", "tel",
+    "cott", "gray", "bjer", "mel", "ler", "son", "berg", "strom", "ham", "mond", "ous", "ton",
+    "ne", "ver", "kar", "sten", "wood", "vik", "dal", "holm", "ro", "bin", "mar", "ley",
+};
+
+static const char* const TITLE_WORDS[] = {
+    "Monty", "Run", "Commando", "Delta", "Last", "Ninja", "Wizball", "Cybernoid", "Armalyte", "Sanxion",
+    "Crazy", "Comets", "Lightforce", "Parallax", "Zoids", "Warhawk", "Thing", "Spring", "Night", "Dream",
+    "Star", "Fire", "Ice", "Space", "Funk", "Blues", "Theme", "Loader", "Intro", "Demo",
+    "Tune", "Song", "Party", "Trip", "Chaos", "Echo", "Shadow", "Storm", "Wave", "Light",
+    "Machine", "Heart", "Rain", "Sun", "Moon", "Dance", "Groove", "Electric", "Lost", "City",
+};
+
+static const char* const RELEASE_GROUPS[] = {
+    "Ocean", "Thalamus", "Hewson", "Gremlin Graphics", "System 3", "Martech", "Firebird", "Elite",
+    "Crest", "Booze Design", "Fairlight", "Triad", "Oxyron", "Censor Design", "Genesis Project",
+    "Vibrants", "Maniacs of Noise", "Offence", "Padua", "Onslaught",
+};
+
+static const char* const LETTER_RANGES[] = {"0-9", "A-F", "G-L", "M-R", "S-Z"};
+
+static const char* const COMMENT_SENTENCES[] = {
+    "Also used in the loader of the disk version.",
+    "Based on a theme from a film.",
+    "The music was converted from the Amiga version.",
+    "Some sources credit a different composer for this tune.",
+    "An unused tune found in the game data.",
+    "Written during a single night at a copy party.",
+    "Placed second in the music competition.",
+    "The drums are played on the third voice only.",
+};
+
+// Small deterministic helpers on top of mt19937_64, whose output is fixed by
+// the standard; the std distributions are not, so the tree would differ
+// between standard libraries.
+class FixtureRandom {
+public:
+    explicit FixtureRandom(uint64_t seed) : engine(seed) {}
+    
+    uint64_t below(uint64_t bound) { return engine() % bound; }
+    double unit() { return (engine() >> 11) * (1.0 / 9007199254740992.0); }
+    bool chance(double probability) { return unit() < probability; }
+    
+    double normal() {
+        double u1 = std::max(unit(), 1e-12);
+        double u2 = unit();
+        return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+    }
+    
+    template <typename T, size_t N>
+    const char* pick(T (&items)[N]) { return items[below(N)]; }
+
+private:
+    std::mt19937_64 engine;
+};
+
+// RFC 1321 MD5, as used for the full-file digests in Songlengths.md5
+class Md5 {
+public:
+    Md5() : state{0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476}, length(0), buffered(0) {}
+    
+    void update(const uint8_t* data, size_t size) {
+        length += size;
+        while (size > 0) {
+            size_t count = std::min(size, sizeof(buffer) - buffered);
+            std::memcpy(buffer + buffered, data, count);
+            buffered += count;
+            data += count;
+            size -= count;
+            if (buffered == sizeof(buffer)) {
+                transform(buffer);
+                buffered = 0;
+            }
+        }
+    }
+    
+    std::array<uint8_t, 16> finish() {
+        uint64_t bit_length = length * 8;
+        uint8_t padding[72] = {0x80};
+        size_t padding_size = (buffered < 56 ? 56 : 120) - buffered;
+        update(padding, padding_size);
+        uint8_t length_bytes[8];
+        for (int i = 0; i < 8; i++) {
+            length_bytes[i] = static_cast<uint8_t>(bit_length >> (8 * i));
+        }
+        update(length_bytes, sizeof(length_bytes));
+        
+        std::array<uint8_t, 16> digest;
+        for (int i = 0; i < 16; i++) {
+            digest[i] = static_cast<uint8_t>(state[i / 4] >> (8 * (i % 4)));
+        }
+        return digest;
+    }
+
+private:
+    static uint32_t rotateLeft(uint32_t value, int bits) { return (value << bits) | (value >> (32 - bits)); }
+    
+    void transform(const uint8_t* block) {
+        static const int shifts[4][4] = {{7, 12, 17, 22}, {5, 9, 14, 20}, {4, 11, 16, 23}, {6, 10, 15, 21}};
+        static const std::array<uint32_t, 64> constants = [] {
+            std::array<uint32_t, 64> table{};
+            for (int i = 0; i < 64; i++) {
+                table[i] = static_cast<uint32_t>(std::floor(std::fabs(std::sin(i + 1.0)) * 4294967296.0));
+            }
+            return table;
+        }();
+        
+        uint32_t words[16];
+        for (int i = 0; i < 16; i++) {
+            words[i] = block[i * 4] | (block[i * 4 + 1] << 8) | (block[i * 4 + 2] << 16) |
+                       (static_cast<uint32_t>(block[i * 4 + 3]) << 24);
+        }
+        
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        for (int i = 0; i < 64; i++) {
+            uint32_t f;
+            int word;
+            if (i < 16) {
+                f = (b & c) | (~b & d);
+                word = i;
+            } else if (i < 32) {
+                f = (d & b) | (~d & c);
+                word = (5 * i + 1) % 16;
+            } else if (i < 48) {
+                f = b ^ c ^ d;
+                word = (3 * i + 5) % 16;
+            } else {
+                f = c ^ (b | ~d);
+                word = (7 * i) % 16;
+            }
+            uint32_t rotated = rotateLeft(a + f + constants[i] + words[word], shifts[i / 16][i % 4]);
+            a = d;
+            d = c;
+            c = b;
+            b += rotated;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+    }
+    
+    uint32_t state[4];
+    uint64_t length;
+    uint8_t buffer[64];
+    size_t buffered;
+};
+
+struct Composer {
+    std::string name;      // "Rob Hubbard"
+    std::string directory; // "MUSICIANS/H/Hubbard_Rob"
+};
+
+struct FixtureTune {
+    std::string path; // "/MUSICIANS/H/Hubbard_Rob/Monty_Run.sid"
+    std::string title;
+    const Composer* composer = nullptr;
+    std::string released;
+    std::vector<int> lengths_ms;
+    std::vector<uint8_t> data;
+};
+
+static std::string capitalize(std::string word) {
+    if (!word.empty() && word[0] >= 'a' && word[0] <= 'z') {
+        word[0] = static_cast<char>(word[0] - 'a' + 'A');
+    }
+    return word;
+}
+
+static std::vector<Composer> makeComposers(FixtureRandom& random, size_t count) {
+    std::vector<Composer> composers;
+    std::unordered_set<std::string> directories;
+    while (composers.size() < count) {
+        std::string surname;
+        int syllables = 2 + static_cast<int>(random.below(2));
+        for (int i = 0; i < syllables; i++) {
+            surname += random.pick(NAME_SYLLABLES);
+        }
+        surname = capitalize(surname);
+        std::string first = random.pick(FIRST_NAMES);
+        
+        char letter = surname[0];
+        std::string directory = std::string("MUSICIANS/") + letter + "/" + surname + "_" + first;
+        for (int suffix = 2; directories.count(directory); suffix++) {
+            directory = std::string("MUSICIANS/") + letter + "/" + surname + "_" + first + "_" + std::to_string(suffix);
+        }
+        directories.insert(directory);
+        composers.push_back({first + " " + surname, directory});
+    }
+    return composers;
+}
+
+// Few composers wrote many tunes: skew the index towards the front
+static const Composer& pickComposer(FixtureRandom& random, const std::vector<Composer>& composers) {
+    double skewed = std::pow(random.unit(), 3.0);
+    return composers[std::min(composers.size() - 1, static_cast<size_t>(skewed * composers.size()))];
+}
+
+static int pickSubtuneCount(FixtureRandom& random) {
+    double roll = random.unit();
+    if (roll < 0.80) return 1;
+    if (roll < 0.92) return 2 + static_cast<int>(random.below(4));
+    if (roll < 0.98) return 6 + static_cast<int>(random.below(10));
+    return 16 + static_cast<int>(random.below(25));
+}
+
+// Log-normal around 2:30, clamped to 5 seconds .. 20 minutes
+static int pickLengthMs(FixtureRandom& random) {
+    double seconds = 150.0 * std::exp(0.8 * random.normal());
+    seconds = std::clamp(seconds, 5.0, 1200.0);
+    int length_ms = static_cast<int>(seconds) * 1000;
+    if (random.chance(0.3)) {
+        length_ms += static_cast<int>(random.below(1000));
+    }
+    return length_ms;
+}
+
+static std::string makeTitle(FixtureRandom& random) {
+    int words = 1 + static_cast<int>(random.below(3));
+    std::string title;
+    for (int i = 0; i < words; i++) {
+        if (i > 0) title += " ";
+        title += random.pick(TITLE_WORDS);
+    }
+    if (random.chance(0.1)) {
+        title += " " + std::to_string(2 + random.below(4));
+    }
+    return title;
+}
+
+static std::string toFilename(const std::string& title) {
+    std::string name = title;
+    std::replace(name.begin(), name.end(), ' ', '_');
+    return name;
+}
+
+static void putBe16(std::vector<uint8_t>& out, size_t offset, uint16_t value) {
+    out[offset] = static_cast<uint8_t>(value >> 8);
+    out[offset + 1] = static_cast<uint8_t>(value);
+}
+
+static void putText(std::vector<uint8_t>& out, size_t offset, const std::string& text) {
+    std::memcpy(out.data() + offset, text.data(), std::min<size_t>(text.size(), 31));
+}
+
+// PSID v2 with a load address in front of the data. init sets the volume and
+// play returns at once; the tune id after the code makes every digest unique.
+static std::vector<uint8_t> makePsid(const FixtureTune& tune, uint32_t tune_id) {
+    const size_t header_size = 0x7c;
+    const uint16_t load_address = 0x1000;
+    std::vector<uint8_t> data(header_size, 0);
+    std::memcpy(data.data(), "PSID", 4);
+    putBe16(data, 0x04, 2);                                              // version
+    putBe16(data, 0x06, header_size);                                    // data offset
+    putBe16(data, 0x0a, load_address);                                   // init
+    putBe16(data, 0x0c, load_address + 6);                               // play
+    putBe16(data, 0x0e, static_cast<uint16_t>(tune.lengths_ms.size())); // songs
+    putBe16(data, 0x10, 1);                                              // start song
+    putText(data, 0x16, tune.title);
+    putText(data, 0x36, tune.composer->name);
+    putText(data, 0x56, tune.released);
+    putBe16(data, 0x76, 0x0014);                                         // PAL, 6581
+    
+    const std::vector<uint8_t> code = {
+        static_cast<uint8_t>(load_address), static_cast<uint8_t>(load_address >> 8),
+        0xa9, 0x0f,             // lda #$0f
+        0x8d, 0x18, 0xd4,       // sta $d418
+        0x60,                   // rts
+        0x60,                   // play: rts
+    };
+    data.insert(data.end(), code.begin(), code.end());
+    for (int i = 0; i < 4; i++) {
+        data.push_back(static_cast<uint8_t>(tune_id >> (8 * i)));
+    }
+    return data;
+}
+
+static std::string formatLength(int length_ms) {
+    char text[32];
+    int seconds = length_ms / 1000;
+    if (length_ms % 1000) {
+        std::snprintf(text, sizeof(text), "%d:%02d.%03d", seconds / 60, seconds % 60, length_ms % 1000);
+    } else {
+        std::snprintf(text, sizeof(text), "%d:%02d", seconds / 60, seconds % 60);
+    }
+    return text;
+}
+
+static std::string formatDigest(const std::array<uint8_t, 16>& digest) {
+    static const char hex[] = "0123456789abcdef";
+    std::string text;
+    for (uint8_t byte : digest) {
+        text += hex[byte >> 4];
+        text += hex[byte & 0x0f];
+    }
+    return text;
+}
+
+static std::vector<FixtureTune> makeTunes(FixtureRandom& random, size_t count) {
+    std::vector<Composer> composers = makeComposers(random, std::max<size_t>(1, count / 15));
+    std::vector<FixtureTune> tunes;
+    std::unordered_set<std::string> paths;
+    tunes.reserve(count);
+    
+    while (tunes.size() < count) {
+        FixtureTune tune;
+        tune.title = makeTitle(random);
+        tune.composer = &pickComposer(random, composers);
+        
+        // Roughly the HVSC split: 80% below MUSICIANS, the rest GAMES and DEMOS
+        std::string directory;
+        double roll = random.unit();
+        if (roll < 0.8) {
+            directory = tune.composer->directory;
+        } else {
+            directory = std::string(roll < 0.9 ? "GAMES/" : "DEMOS/") + random.pick(LETTER_RANGES);
+        }
+        std::string base = "/" + directory + "/" + toFilename(tune.title);
+        tune.path = base + ".sid";
+        for (int suffix = 2; paths.count(tune.path); suffix++) {
+            tune.path = base + "_" + std::to_string(suffix) + ".sid";
+        }
+        paths.insert(tune.path);
+        
+        int year = 1982 + static_cast<int>(std::clamp(6.0 + 6.0 * random.normal(), 0.0, 42.0));
+        tune.released = std::to_string(year) + " " + random.pick(RELEASE_GROUPS);
+        
+        int subtunes = pickSubtuneCount(random);
+        for (int i = 0; i < subtunes; i++) {
+            tune.lengths_ms.push_back(pickLengthMs(random));
+        }
+        tune.data = makePsid(tune, static_cast<uint32_t>(tunes.size()));
+        tunes.push_back(std::move(tune));
+    }
+    
+    std::sort(tunes.begin(), tunes.end(), [](const FixtureTune& a, const FixtureTune& b) { return a.path < b.path; });
+    return tunes;
+}
+
+static bool writeSonglengths(const std::filesystem::path& file_path, const std::vector<FixtureTune>& tunes) {
+    FILE* file = std::fopen(file_path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    std::fputs("[Database]\n", file);
+    for (const auto& tune : tunes) {
+        Md5 md5;
+        md5.update(tune.data.data(), tune.data.size());
+        std::fprintf(file, "; %s\n%s=", tune.path.c_str(), formatDigest(md5.finish()).c_str());
+        for (size_t i = 0; i < tune.lengths_ms.size(); i++) {
+            std::fprintf(file, "%s%s", i ? " " : "", formatLength(tune.lengths_ms[i]).c_str());
+        }
+        std::fputc('\n', file);
+    }
+    return std::fclose(file) == 0;
+}
+
+// Field mix of the real STIL: every entry names a title or artist, half have
+// a comment, some spanning lines, and multi-song tunes get per-subtune blocks
+static bool writeStil(const std::filesystem::path& file_path, const std::vector<FixtureTune>& tunes,
+                      FixtureRandom& random, size_t& entries) {
+    FILE* file = std::fopen(file_path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    std::fputs("### STIL - SID Tune Information List (synthetic fixture) ###\n#\n", file);
+    
+    entries = 0;
+    for (const auto& tune : tunes) {
+        if (!random.chance(0.33)) {
+            continue;
+        }
+        entries++;
+        std::fprintf(file, "\n%s\n", tune.path.c_str());
+        
+        int blocks = 1;
+        if (tune.lengths_ms.size() > 1 && random.chance(0.5)) {
+            blocks = static_cast<int>(std::min<size_t>(tune.lengths_ms.size(), 4));
+        }
+        for (int block = 0; block < blocks; block++) {
+            if (blocks > 1) {
+                std::fprintf(file, " (#%d)\n", block + 1);
+            }
+            if (random.chance(0.7)) {
+                std::fprintf(file, "   TITLE: %s\n", makeTitle(random).c_str());
+            }
+            if (random.chance(0.4)) {
+                std::string surname = capitalize(std::string(random.pick(NAME_SYLLABLES)) + random.pick(NAME_SYLLABLES));
+                std::fprintf(file, "  ARTIST: %s %s\n", random.pick(FIRST_NAMES), surname.c_str());
+            }
+            if (random.chance(0.5)) {
+                std::fprintf(file, " COMMENT: %s\n", random.pick(COMMENT_SENTENCES));
+                int continuation_lines = random.chance(0.3) ? 1 + static_cast<int>(random.below(3)) : 0;
+                for (int i = 0; i < continuation_lines; i++) {
+                    std::fprintf(file, "          %s\n", random.pick(COMMENT_SENTENCES));
+                }
+            }
+        }
+    }
+    
+    return std::fclose(file) == 0;
+}
+
+static bool writeTuneFiles(const std::filesystem::path& root, const std::vector<FixtureTune>& tunes) {
+    std::filesystem::path current_directory;
+    for (const auto& tune : tunes) {
+        std::filesystem::path path = root / tune.path.substr(1);
+        if (path.parent_path() != current_directory) {
+            current_directory = path.parent_path();
+            std::error_code error;
+            std::filesystem::create_directories(current_directory, error);
+        }
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            std::cerr << "nancyplayer_hvsc_fixture: cannot write " << path.string() << std::endl;
+            return false;
+        }
+        bool written = std::fwrite(tune.data.data(), 1, tune.data.size(), file) == tune.data.size();
+        if (std::fclose(file) != 0 || !written) {
+            std::cerr << "nancyplayer_hvsc_fixture: cannot write " << path.string() << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void printUsage() {
+    std::cerr << "Usage: nancyplayer_hvsc_fixture [options] <output dir>\n"
+              << "  -n, --songs N   number of tunes (default: 60000)\n"
+              << "  -s, --seed N    random seed, equal seeds give equal trees (default: 1)\n"
+              << "  --no-files      only write DOCUMENTS, enough for catalog and search runs\n";
+}
+
+int main(int argc, char** argv) {
+    size_t song_count = 60000;
+    uint64_t seed = 1;
+    bool write_files = true;
+    std::string output;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if ((arg == "-n" || arg == "--songs") && has_value) {
+            song_count = std::strtoull(argv[++i], nullptr, 10);
+        } else if ((arg == "-s" || arg == "--seed") && has_value) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--no-files") {
+            write_files = false;
+        } else if (arg[0] != '-' && output.empty()) {
+            output = arg;
+        } else {
+            printUsage();
+            return arg == "-h" || arg == "--help" ? 0 : 2;
+        }
+    }
+    if (output.empty() || song_count == 0) {
+        printUsage();
+        return 2;
+    }
+    
+    auto started = std::chrono::steady_clock::now();
+    std::filesystem::path root = output;
+    std::error_code error;
+    
+    // Config::validateHvscRoot looks for all four top-level directories
+    for (const char* directory : {"DEMOS", "GAMES", "MUSICIANS", "DOCUMENTS"}) {
+        std::filesystem::create_directories(root / directory, error);
+        if (error) {
+            std::cerr << "nancyplayer_hvsc_fixture: cannot create " << (root / directory).string() << std::endl;
+            return 1;
+        }
+    }
+    
+    FixtureRandom random(seed);
+    std::vector<FixtureTune> tunes = makeTunes(random, song_count);
+    
+    if (!writeSonglengths(root / "DOCUMENTS" / "Songlengths.md5", tunes)) {
+        std::cerr << "nancyplayer_hvsc_fixture: cannot write Songlengths.md5" << std::endl;
+        return 1;
+    }
+    size_t stil_entries = 0;
+    if (!writeStil(root / "DOCUMENTS" / "STIL.txt", tunes, random, stil_entries)) {
+        std::cerr << "nancyplayer_hvsc_fixture: cannot write STIL.txt" << std::endl;
+        return 1;
+    }
+    if (write_files && !writeTuneFiles(root, tunes)) {
+        return 1;
+    }
+    
+    size_t subtunes = 0;
+    for (const auto& tune : tunes) {
+        subtunes += tune.lengths_ms.size();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::printf("%zu tunes (%zu subtunes), %zu STIL entries%s written to %s in %.1fs\n",
+                tunes.size(), subtunes, stil_entries, write_files ? "" : ", no SID files", root.string().c_str(), elapsed);
+    return 0;
+}